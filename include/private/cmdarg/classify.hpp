@@ -0,0 +1,52 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_CLASSIFY_H_
+#define CMDARG_CLASSIFY_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cmdarg::classify {
+
+/*
+ * Pre-pass of the parse engine: the kind of every token of a command line
+ * is decided in bulk, before dispatching any of them, so that the dispatch
+ * loop reads one byte per token instead of branching on its first bytes.
+ */
+
+enum Kind : std::uint8_t {
+    POSITIONAL = 0,      // also "-" and the empty string
+    SHORT = 1,           // -x...
+    LONG = 2,            // --name[=value]
+    END_OF_OPTIONS = 3,  // --
+};
+
+constexpr std::uint32_t NONE = ~0U;
+
+// Kind of a single token, as build computes it
+inline std::uint8_t kindOf(std::string_view token) {
+    if (token.size() < 2 || token[0] != '-') return POSITIONAL;
+    if (token[1] != '-') return SHORT;
+    return (token.size() == 2) ? END_OF_OPTIONS : LONG;
+}
+
+struct Table {
+    std::vector<std::uint8_t> kinds;
+
+    // Offset of the first '=' of LONG tokens, NONE if there is none (or the
+    // token is not LONG)
+    std::vector<std::uint32_t> equals;
+};
+
+// Fills table (reusing its memory) with one entry per token
+extern void build(std::size_t count, const std::string_view tokens[],
+                  Table *table);
+
+}  // namespace cmdarg::classify
+
+#endif  // CMDARG_CLASSIFY_H_
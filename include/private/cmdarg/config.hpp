@@ -0,0 +1,57 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_CONFIG_H_
+#define CMDARG_CONFIG_H_
+
+// System headers
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include <cmdarg/schema.hpp>
+
+namespace cmdarg::config {
+
+/*
+ * Configuration files use a small subset of INI/TOML:
+ *
+ *     # comment (or ; comment)
+ *     count = 3
+ *     color = "green"            # inline comments after values
+ *     name = 'literal string'
+ *
+ *     [build]                    # keys for the "build" subcommand
+ *     jobs = 8
+ *
+ *     [run.fast]                 # keys for "run fast"
+ *
+ * Keys are the long names of optional arguments. Double-quoted values accept
+ * the escapes \" \\ \n and \t, single-quoted ones are taken literally.
+ */
+
+// Name and (unescaped) value of a configuration key, in file order
+using Value = std::pair<std::string, std::string>;
+
+// Scans data in a single pass and appends to out the keys of the given
+// section that name an optional argument of schema; any other key is skipped
+// without being converted. Repeated keys keep the last value. Returns 0, or
+// the number of the first malformed line.
+extern int read(const char *data, std::size_t size, std::string_view section,
+                const schema::View &schema, std::vector<Value> *out);
+
+// Maps the file at path and reads it as above; returns -1 on I/O errors
+extern int load(const std::string &path, std::string_view section,
+                const schema::View &schema, std::vector<Value> *out);
+
+// Parses boolean values of arguments not taking parameters ("true", "yes",
+// "on", "1" and their opposites), returns false if value is none of them
+extern bool parseBool(std::string_view value, bool *out);
+
+}  // namespace cmdarg::config
+
+#endif  // CMDARG_CONFIG_H_
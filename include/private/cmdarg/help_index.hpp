@@ -0,0 +1,71 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_HELP_INDEX_H_
+#define CMDARG_HELP_INDEX_H_
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include <cmdarg/argument.hpp>
+
+namespace cmdarg {
+
+// Inverted index over the names and help text of arguments, for --help=TERM.
+// Words (lowercase, split at anything but letters and digits) are kept
+// sorted with their postings in one flat array, so a term and all the words
+// it prefixes are a single binary search away.
+class HelpIndex {
+    // Where a word appears, by decreasing relevance
+    enum Field : std::uint8_t {
+        NAME_WORD = 1,
+        HELP_WORD = 2,
+    };
+
+    struct Posting {
+        std::uint32_t argument;
+        Field field;
+    };
+
+    // Whole long names, lowercase and sorted, with their argument
+    std::vector<std::pair<std::string, std::uint32_t>> _names;
+
+    // Postings of _words[i] are [_first[i], _first[i + 1])
+    std::vector<std::string> _words;
+    std::vector<std::uint32_t> _first;
+    std::vector<Posting> _postings;
+    std::uint32_t _count = 0;
+
+    // Per-argument scratch of search, sized once by build and restored
+    // after each search, so queries cost only what they match
+    mutable std::vector<std::uint32_t> _score;
+    mutable std::vector<std::uint32_t> _sum;
+    mutable std::vector<std::uint32_t> _best;
+
+ public:
+    HelpIndex() = default;
+
+    // Indexes args, referred to by their position in it
+    void build(const std::vector<const Argument *> &args);
+    void clear();
+
+    inline bool empty() const {
+        return _count == 0;
+    }
+
+    // Returns the arguments whose name starts with term, or matching every
+    // word of term (as a whole word or a prefix of one), best first: the
+    // whole name, then words of the name, then words of the help, exact
+    // matches before prefixes; ties keep the order of args
+    std::vector<std::uint32_t> search(std::string_view term) const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_HELP_INDEX_H_
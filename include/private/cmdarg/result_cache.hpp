@@ -0,0 +1,81 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_RESULT_CACHE_H_
+#define CMDARG_RESULT_CACHE_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Project headers
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+/*
+ * Results of past parses, looked up by a key that spells out everything
+ * they depend on (the tokens, the environment variables of the arguments)
+ * and by its 64-bit fingerprint. Entries are evicted least recently used
+ * first, so that their approximate size stays within the capacity.
+ *
+ * Only one entry is kept per fingerprint: a colliding key is a miss, and
+ * replaces the entry when inserted.
+ */
+class ResultCache {
+ public:
+    using Result = std::shared_ptr<const Options>;
+
+ private:
+    struct Entry {
+        std::string key;
+        std::uint64_t hash;
+        Result result;
+        std::size_t bytes;
+    };
+
+    // Most recently used first
+    std::list<Entry> _entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> _index;
+
+    std::size_t _capacity = 0;
+    std::size_t _bytes = 0;
+    std::uint64_t _hits = 0;
+    std::uint64_t _misses = 0;
+
+    void _erase(std::list<Entry>::iterator it);
+    void _evict(std::size_t capacity);
+
+ public:
+    // Fingerprint of a key
+    static std::uint64_t hash(std::string_view key);
+
+    // Evicts entries down to bytes, 0 disables the cache
+    void setCapacity(std::size_t bytes);
+
+    inline std::size_t capacity() const {
+        return _capacity;
+    }
+
+    // Returns the result stored under key and marks it as recently used, or
+    // nullptr; counts a hit or a miss
+    Result find(std::string_view key, std::uint64_t hash);
+
+    // Stores result under key, unless it alone exceeds the capacity
+    void insert(std::string_view key, std::uint64_t hash, Result result);
+
+    // Drops all the entries, counters are kept
+    void clear();
+
+    CacheStats stats() const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_RESULT_CACHE_H_
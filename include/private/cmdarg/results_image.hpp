@@ -0,0 +1,63 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_RESULTS_IMAGE_H_
+#define CMDARG_RESULTS_IMAGE_H_
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Project headers
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg::results {
+
+/*
+ * Layout of a results image, all references are offsets from its start:
+ *
+ *     Header
+ *     Entry[n_values]                sorted by key
+ *     char strings[strings_size]     NUL-terminated keys and values
+ *
+ * Values may hold NUL bytes themselves, only their length is exact.
+ */
+
+constexpr char MAGIC[8] = {'C', 'M', 'D', 'A', 'R', 'G', 'R', '\0'};
+constexpr std::uint32_t VERSION = 3;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t size;
+    std::uint64_t checksum;
+    std::uint64_t schema_hash;
+
+    std::uint32_t n_values;
+    std::uint32_t entries;
+    std::uint32_t strings;
+    std::uint32_t strings_size;
+};
+
+struct Entry {
+    // Offsets in the string pool
+    std::uint32_t key;
+    std::uint32_t value;
+
+    std::uint32_t key_length;
+    std::uint32_t value_length;
+    std::uint32_t source;
+};
+
+// Packs values, with the given sources (one per value, in the same order),
+// in an image; out is padded to a multiple of 8 bytes
+extern void build(const Options &values, const std::vector<Source> &sources,
+                  std::uint64_t schema_hash, std::string *out);
+
+}  // namespace cmdarg::results
+
+#endif  // CMDARG_RESULTS_IMAGE_H_
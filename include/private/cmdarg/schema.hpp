@@ -0,0 +1,237 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_SCHEMA_H_
+#define CMDARG_SCHEMA_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/argument.hpp>
+
+namespace cmdarg::schema {
+
+/*
+ * A compiled schema is a single, position-independent block of memory
+ * holding everything the parse engine needs: one record per argument, the
+ * lookup tables for long and short options and all the strings. Every
+ * reference inside the block is an offset, so the same bytes can be built in
+ * memory by the parser, written to a file and later mapped (or embedded in
+ * the executable) and used as they are.
+ *
+ * What dispatching an option reads (records, hash slots and shorts) is kept
+ * apart from what only help, completion and resetting values need, which
+ * lives in separate arrays indexed like the records: a record takes 12 bytes
+ * and a hash slot 8, so lookups stay within a few cache lines.
+ *
+ *     Header
+ *     Record records[n]                  optional ones first
+ *     Slot hash[hash_slots]              name hash, record + 1 (0 if empty)
+ *     uint32_t shorts[256]               short option -> record + 1
+ *     uint32_t sorted[n_optional]        records sorted by long name
+ *     uint32_t defaults[n]               cold: offsets in strings
+ *     uint32_t helps[n]
+ *     uint32_t envs[n]
+ *     uint32_t choice_lists[n]           offsets in choices, or NONE
+ *     uint32_t choices[]                 for each list: count, then strings
+ *     char strings[strings_size]         NUL-terminated
+ */
+
+constexpr char MAGIC[8] = {'C', 'M', 'D', 'A', 'R', 'G', 'S', '\0'};
+constexpr std::uint32_t VERSION = 4;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::uint32_t NONE = ~0U;
+
+// Long names are stored with a 16-bit length
+constexpr std::size_t MAX_NAME_LENGTH = 0xFFFE;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t size;
+    std::uint64_t checksum;
+
+    std::uint32_t n_optional;
+    std::uint32_t n_required;
+    std::uint32_t hash_slots;
+
+    std::uint32_t records;
+    std::uint32_t hash;
+    std::uint32_t shorts;
+    std::uint32_t sorted;
+    std::uint32_t defaults;
+    std::uint32_t helps;
+    std::uint32_t envs;
+    std::uint32_t choice_lists;
+    std::uint32_t choices;
+    std::uint32_t strings;
+    std::uint32_t strings_size;
+};
+
+struct Record {
+    // Offset in the string pool
+    std::uint32_t long_opt;
+    std::uint16_t long_opt_length;
+
+    // Identifier of a predefined action (see actions::predefinedId), or
+    // CUSTOM_ACTION + index in the table of custom actions of the parser
+    // that built the schema in memory
+    std::uint16_t action;
+    char short_opt;
+    std::uint8_t flags;
+    std::uint16_t reserved;
+};
+
+struct Slot {
+    std::uint32_t hash;
+    std::uint32_t record;
+};
+
+// Record::flags
+constexpr std::uint8_t FLAG_REQUIRED = 0x1;
+constexpr std::uint8_t FLAG_PARAMETER_SHIFT = 1;
+constexpr std::uint8_t FLAG_PARAMETER_MASK = 0x3 << FLAG_PARAMETER_SHIFT;
+constexpr std::uint8_t FLAG_ENV = 0x8;
+
+// The default is computed by a provider of the parser that built the schema
+// in memory, never set in saved schemas
+constexpr std::uint8_t FLAG_COMPUTED = 0x10;
+
+constexpr std::uint16_t CUSTOM_ACTION = 0x8000;
+
+// Result codes, also returned by the public API of the parser
+enum Result {
+    OK = 0,
+    INVALID = -1,
+    UNSUPPORTED_VERSION = -2,
+    CORRUPTED = -3,
+    UNSUPPORTED = -4,
+    IO_ERROR = -5,
+};
+
+extern std::uint32_t hashName(std::string_view name);
+
+// FNV-1a over 64-bit words, enough to detect truncated or damaged blocks;
+// pass the checksum of the previous bytes as seed to continue it
+constexpr std::uint64_t CHECKSUM_SEED = 14695981039346656037ULL;
+extern std::uint64_t checksum(const void *data, std::size_t size,
+                              std::uint64_t seed = CHECKSUM_SEED);
+
+// Compiles optional and required arguments into out. Actions that are not
+// predefined are appended to custom_actions; if that is nullptr (the schema
+// must be saved) they make the build fail with UNSUPPORTED.
+extern int build(const std::vector<Argument> &optional,
+                 const std::vector<Argument> &required,
+                 std::vector<actions::Type> *custom_actions,
+                 std::vector<std::uint64_t> *out);
+
+// Validates a block of memory that should hold a compiled schema
+extern int check(const void *data, std::size_t size);
+
+// Read-only access to a compiled (and checked) schema
+class View {
+    const char *_base = nullptr;
+    const Header *_header = nullptr;
+
+    inline std::uint32_t _cold(std::uint32_t array,
+                               std::uint32_t index) const {
+        return reinterpret_cast<const std::uint32_t *>(_base + array)[index];
+    }
+
+ public:
+    View() = default;
+    explicit View(const void *data)
+        : _base(static_cast<const char *>(data)),
+          _header(static_cast<const Header *>(data)) {
+    }
+
+    inline bool empty() const {
+        return _header == nullptr;
+    }
+
+    inline const Header &header() const {
+        return *_header;
+    }
+
+    inline std::size_t size() const {
+        return _header->size;
+    }
+
+    inline const void *data() const {
+        return _base;
+    }
+
+    inline std::uint32_t optionalCount() const {
+        return _header->n_optional;
+    }
+
+    inline std::uint32_t requiredCount() const {
+        return _header->n_required;
+    }
+
+    // Records [0, optionalCount()) are optional arguments, the following
+    // requiredCount() ones are required, both in registration order
+    inline const Record &record(std::uint32_t index) const {
+        return reinterpret_cast<const Record *>(_base +
+                                                _header->records)[index];
+    }
+
+    inline const char *string(std::uint32_t offset) const {
+        return _base + _header->strings + offset;
+    }
+
+    inline std::string_view longOpt(const Record &r) const {
+        return {string(r.long_opt), r.long_opt_length};
+    }
+
+    inline Argument::ParameterRequired parameter(const Record &r) const {
+        return static_cast<Argument::ParameterRequired>(
+            (r.flags & FLAG_PARAMETER_MASK) >> FLAG_PARAMETER_SHIFT);
+    }
+
+    // Cold data of record index, only needed by help, completion and when
+    // values are reset; 0 (the empty string) when absent
+    inline const char *defaultValue(std::uint32_t index) const {
+        return string(_cold(_header->defaults, index));
+    }
+
+    inline const char *help(std::uint32_t index) const {
+        return string(_cold(_header->helps, index));
+    }
+
+    inline const char *env(std::uint32_t index) const {
+        return string(_cold(_header->envs, index));
+    }
+
+    // Fills out (reusing its memory) with the strings of the choices of
+    // record index, followed by nullptr; returns false, leaving out empty,
+    // if it has none
+    bool choices(std::uint32_t index, std::vector<const char *> *out) const;
+
+    // Returns the optional argument with the given long name, or NONE
+    std::uint32_t findLong(std::string_view name) const;
+
+    // Returns the optional argument with the given short name, or NONE
+    std::uint32_t findShort(char c) const;
+
+    // Returns the range [*first, *last) of the optional arguments whose name
+    // starts with prefix, in lexicographic order; use sortedAt to access them
+    void findPrefix(std::string_view prefix, std::uint32_t *first,
+                    std::uint32_t *last) const;
+
+    inline std::uint32_t sortedAt(std::uint32_t position) const {
+        return reinterpret_cast<const std::uint32_t *>(
+            _base + _header->sorted)[position];
+    }
+};
+
+}  // namespace cmdarg::schema
+
+#endif  // CMDARG_SCHEMA_H_
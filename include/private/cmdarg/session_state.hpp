@@ -0,0 +1,66 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_SESSION_STATE_H_
+#define CMDARG_SESSION_STATE_H_
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Project headers
+#include <cmdarg/argument.hpp>
+#include <cmdarg/error.hpp>
+#include <cmdarg/help_formatter.hpp>
+#include <cmdarg/schema.hpp>
+#include <cmdarg/session.hpp>
+
+namespace cmdarg::session {
+
+constexpr std::uint32_t NONE = ~0U;
+
+// What a word means in place of an option, which depends on the word alone
+struct Option {
+    // First error found in the word, if any
+    ParseError::Kind error = ParseError::Kind::NONE;
+    std::string error_token;
+
+    // Record taking the next word as its value, NONE if there is none
+    std::uint32_t takes_next = NONE;
+};
+
+struct Token {
+    std::string text;
+
+    // Set by edits, cleared once kind and option are computed again
+    bool dirty = true;
+    std::uint8_t kind = 0;
+    Option option;
+
+    // Record the word was last converted for as a value (or positional),
+    // NONE if never, and whether its action accepted it
+    std::uint32_t value_record = NONE;
+    bool value_valid = false;
+};
+
+struct State {
+    std::vector<Token> tokens;
+
+    // Checksum of the schema the tokens were checked against
+    std::uint64_t schema = 0;
+
+    std::vector<TokenError> errors;
+};
+
+// Computes again what the edits changed in state and rebuilds its errors;
+// arguments are indexed like schema records
+extern void validate(const schema::View &schema,
+                     const std::vector<Argument> &optional,
+                     const std::vector<Argument> &required,
+                     const HelpFormatter &formatter, State *state);
+
+}  // namespace cmdarg::session
+
+#endif  // CMDARG_SESSION_STATE_H_
@@ -0,0 +1,73 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_STRING_ARENA_H_
+#define CMDARG_STRING_ARENA_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cmdarg {
+
+// Bump allocator for the strings registered in a parser, which are copied
+// (and deduplicated) here so that callers do not have to keep them alive.
+// Memory comes in chunks of doubling size and is released only with the
+// arena, so thousands of strings cost a handful of allocations.
+class StringArena {
+    static constexpr std::size_t FIRST_CHUNK_SIZE = 4096;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    struct Slot {
+        const char *str = nullptr;
+        std::uint32_t length;
+        std::uint32_t hash;
+    };
+
+    std::vector<Chunk> _chunks;
+    std::size_t _used = 0;
+
+    // Open addressing, at most half full
+    std::vector<Slot> _slots;
+    std::size_t _count = 0;
+
+    void _rehash(std::size_t n_slots);
+
+ public:
+    StringArena() = default;
+
+    StringArena(const StringArena &rhs) = delete;
+    StringArena &operator=(const StringArena &rhs) = delete;
+
+    StringArena(StringArena &&rhs) = default;
+    StringArena &operator=(StringArena &&rhs) = default;
+
+    // Returns a NUL-terminated copy of s, the same one for equal strings
+    const char *intern(std::string_view s);
+
+    // Same as above, nullptr stays nullptr
+    inline const char *intern(const char *s) {
+        return s ? intern(std::string_view{s}) : nullptr;
+    }
+
+    // Copies a null-terminated list of strings, interning each of them
+    const char *const *internList(const char *const *list);
+
+    void *allocate(std::size_t size, std::size_t alignment);
+
+    inline std::size_t chunkCount() const {
+        return _chunks.size();
+    }
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_STRING_ARENA_H_
@@ -0,0 +1,60 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_TRIE_H_
+#define CMDARG_TRIE_H_
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cmdarg {
+
+// Prefix tree mapping strings to integer values, stored as a flat array of
+// nodes. Children are kept in lexicographic order, so completions come out
+// sorted without any extra work at query time.
+class Trie {
+ public:
+    using Entry = std::pair<std::string, int>;
+
+ private:
+    static constexpr std::uint32_t NONE = ~0U;
+
+    struct Node {
+        char c;
+        std::uint32_t first_child = NONE;
+        std::uint32_t next_sibling = NONE;
+        std::int32_t key = -1;
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<Entry> _entries;
+
+ public:
+    Trie() = default;
+
+    // Replaces the content of the trie, duplicated keys keep the first value
+    void build(std::vector<Entry> entries);
+    void clear();
+
+    inline bool empty() const {
+        return _entries.empty();
+    }
+
+    // Returns the value associated with key, or -1
+    int find(std::string_view key) const;
+
+    // Appends to out all the keys starting with prefix, in order
+    void complete(std::string_view prefix, std::vector<std::string> *out) const;
+
+ private:
+    std::uint32_t _child(std::uint32_t node, char c) const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_TRIE_H_
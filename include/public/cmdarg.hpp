@@ -7,7 +7,20 @@
 
 #include <cmdarg/actions.hpp>
 #include <cmdarg/argument.hpp>
+#include <cmdarg/binding.hpp>
+#include <cmdarg/completion.hpp>
+#include <cmdarg/error.hpp>
 #include <cmdarg/help_formatter.hpp>
+#include <cmdarg/live.hpp>
 #include <cmdarg/parser.hpp>
+#include <cmdarg/payload.hpp>
+#include <cmdarg/process.hpp>
+#include <cmdarg/registry.hpp>
+#include <cmdarg/results.hpp>
+#include <cmdarg/session.hpp>
+#include <cmdarg/subcommand.hpp>
+#include <cmdarg/suggest.hpp>
+#include <cmdarg/tokenizer.hpp>
+#include <cmdarg/visitor.hpp>
 
 #endif  // CMDARG_H_
@@ -25,9 +25,17 @@ extern int store_true(std::string *dest, const Argument &opt,
 extern int store_false(std::string *dest, const Argument &opt,
                        const std::string &_src_unused);
 
+extern int store_choice(std::string *dest, const Argument &opt,
+                        const std::string &src);
+
 extern int show_help_and_exit(std::string *dest, const Argument &opt,
                               const std::string &_src_unused);
 
+// Stores the value as it is, "@path" values are read through a Payload only
+// when needed (see cmdarg/payload.hpp)
+extern int store_payload(std::string *dest, const Argument &opt,
+                         const std::string &src);
+
 /*
  * ┌───────────────────────────────────────────────┐
  * │                 Store Actions                 │
@@ -81,6 +89,23 @@ extern const Type increment_long_long;
 extern const Type increment_float;
 extern const Type increment_double;
 
+/*
+ * ┌───────────────────────────────────────────────┐
+ * │              Predefined Actions               │
+ * └───────────────────────────────────────────────┘
+ */
+
+// Stable identifiers of all the actions above, used to store them in compiled
+// schemas; predefinedId returns -1 for any other action and predefined
+// returns nullptr for an unknown identifier
+extern int predefinedId(Type action);
+extern Type predefined(int id);
+
+// While quiet (for the calling thread only), the actions above report
+// invalid values through their result alone, without printing anything on
+// stderr; returns the previous setting
+extern bool setQuiet(bool quiet);
+
 }  // namespace actions
 }  // namespace cmdarg
 
@@ -5,10 +5,46 @@
 #ifndef CMDARG_ARGUMENT_H_
 #define CMDARG_ARGUMENT_H_
 
+// System headers
+#include <string>
+#include <string_view>
+
+// Project headers
 #include <cmdarg/actions.hpp>
 
 namespace cmdarg {
 
+// Values of the arguments of a parser, as default providers read them (see
+// Parser::value)
+class ValueReader {
+ public:
+    virtual int value(const std::string &name, std::string *out) = 0;
+
+ protected:
+    ~ValueReader() noexcept = default;
+};
+
+// Computes a default value into dest (which holds default_value), possibly
+// reading other values with values->value(...); returns 0, or non-zero (e.g.
+// what a failing values->value returned) to fail
+using DefaultProvider = int (*)(std::string *dest, ValueReader *values);
+
+// Typed field written by Parser::parseInto with the value of an argument;
+// use cmdarg::bind to make one (see cmdarg/binding.hpp)
+struct Destination {
+    // Converts value, as produced by the action, into the field: a member of
+    // the struct at target, or the variable itself; returns 0 on success
+    using Store = int (*)(void *target, std::string_view value);
+
+    Store store = nullptr;
+
+    // Written in place of a struct member when not nullptr
+    void *variable = nullptr;
+
+    // Identifies the struct type of members, nullptr for variables
+    const void *owner = nullptr;
+};
+
 struct Argument {
  private:
     using ActionType = actions::Type;
@@ -27,6 +63,20 @@ struct Argument {
     const char *help = "";
     const char *default_value = "";
     const ActionType action = actions::store_string;
+
+    // Null-terminated list of accepted values, used by actions::store_choice
+    const char *const *choices = nullptr;
+
+    // Environment variable providing the value when the argument is not
+    // given on the command line (optional arguments only)
+    const char *env = nullptr;
+
+    // Computes the default value only when it is first read with
+    // Parser::value, and at most once per parse; see there
+    const DefaultProvider default_provider = nullptr;
+
+    // Field receiving the value with Parser::parseInto, instead of a map
+    const Destination destination = {};
 };
 
 }  // namespace cmdarg
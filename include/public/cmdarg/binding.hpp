@@ -0,0 +1,205 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_BINDING_H_
+#define CMDARG_BINDING_H_
+
+// System headers
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Project headers
+#include <cmdarg/argument.hpp>
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+/*
+ * Arguments written straight into the fields of a configuration struct (or
+ * into plain variables) instead of a map of strings:
+ *
+ *     struct Config {
+ *         int port = 80;
+ *         double timeout = 1.5;
+ *         bool verbose = false;
+ *         std::string host;
+ *     };
+ *
+ *     using cmdarg::Argument, cmdarg::bind;
+ *     static const Argument options[] = {
+ *         {.long_opt = "port",
+ *          .parameter_required = Argument::ParameterRequired::REQUIRED,
+ *          .action = cmdarg::actions::store_positive_int,
+ *          .destination = bind<&Config::port>()},
+ *         {.long_opt = "verbose",
+ *          .action = cmdarg::actions::store_true,
+ *          .destination = bind<&Config::verbose>()},
+ *         {.long_opt = "log-level", ...
+ *          .destination = bind(&log_level)},
+ *     };
+ *     parser.addArguments(options, 3);
+ *
+ *     cmdarg::Binding<Config> binding{&parser};
+ *     Config config;
+ *     binding.parse(argc, argv, &config);
+ *
+ * Each value is checked by the action of its argument, then converted into
+ * its field during the parse: no map and no strings are kept, and there is
+ * no second pass. Supported fields are bool ("true" or "false", as stored
+ * by store_true and store_false), integer and floating point numbers, and
+ * std::string.
+ *
+ * Defaults are converted only once, into a default instance of the struct
+ * built on the first parse (and again whenever the arguments of the parser
+ * change), which is then copied over the destination before each parse.
+ * Arguments with an empty default_value keep the value of the initializers
+ * of the struct (or of the variable) instead.
+ *
+ * The parse works as Parser::visit does: only the command line is read (no
+ * configuration file or environment). Each occurrence of an option goes
+ * through its action as in Parser::parse and is stored right away, so the
+ * last one wins and increment actions count occurrences.
+ */
+
+namespace binding {
+
+template <class T>
+inline constexpr bool unsupported = false;
+
+// Returns 0, or -1 if value is not valid for T (or out of its range)
+template <class T>
+int convert(std::string_view value, T *out) {
+    if constexpr (std::is_same_v<T, bool>) {
+        if (value != "true" && value != "false") return -1;
+        *out = (value == "true");
+        return 0;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        // Numeric actions take a leading sign, from_chars only takes '-'
+        if (value.size() > 1 && value[0] == '+' && value[1] != '-') {
+            value.remove_prefix(1);
+        }
+
+        const char *end = value.data() + value.size();
+        T number;
+        auto res = std::from_chars(value.data(), end, number);
+        if (res.ec != std::errc{} || res.ptr != end) return -1;
+        *out = number;
+        return 0;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        *out = value;
+        return 0;
+    } else {
+        static_assert(unsupported<T>, "cannot bind arguments to this type");
+    }
+}
+
+template <class M>
+struct MemberOf;
+
+template <class C, class T>
+struct MemberOf<T C::*> {
+    using Owner = C;
+    using Type = T;
+};
+
+// Only its address matters, it identifies C in Destination::owner
+template <class C>
+inline constexpr char owner = 0;
+
+template <auto Member>
+int storeMember(void *base, std::string_view value) {
+    using Owner = typename MemberOf<decltype(Member)>::Owner;
+    return convert(value, &(static_cast<Owner *>(base)->*Member));
+}
+
+template <class T>
+int storeVariable(void *variable, std::string_view value) {
+    return convert(value, static_cast<T *>(variable));
+}
+
+}  // namespace binding
+
+// Destination of a member of a struct, e.g. bind<&Config::port>()
+template <auto Member>
+constexpr Destination bind() {
+    using Owner = typename binding::MemberOf<decltype(Member)>::Owner;
+    return {
+        .store = binding::storeMember<Member>,
+        .owner = &binding::owner<Owner>,
+    };
+}
+
+// Destination of a variable, which must outlive the parser
+template <class T>
+constexpr Destination bind(T *variable) {
+    return {
+        .store = binding::storeVariable<T>,
+        .variable = variable,
+    };
+}
+
+// Parses into Config the arguments bound to its members (and into the
+// variables the ones bound to variables) of a parser, which must outlive it
+template <class Config>
+class Binding {
+    static constexpr const void *_OWNER = &binding::owner<Config>;
+
+    Parser *_parser;
+    Config _defaults{};
+    bool _defaults_valid = false;
+
+    // Schema the defaults were converted for
+    std::uint64_t _defaults_hash = 0;
+
+ public:
+    explicit Binding(Parser *parser) : _parser(parser) {
+    }
+
+    /*
+     * Copies the default instance over config, then parses argv into it;
+     * the default instance is built on the first call, and again after
+     * arguments are added. Returns as Parser::parseInto does.
+     */
+    inline int parse(int argc, char *const argv[], Config *config) {
+        int res = _prepare(config);
+        if (res) return res;
+        return _parser->parseInto(argc, argv, config, _OWNER);
+    }
+
+    // Same as above, argv[0] is the program name
+    inline int parse(int argc, const std::string_view argv[],
+                     Config *config) {
+        int res = _prepare(config);
+        if (res) return res;
+        return _parser->parseInto(argc, argv, config, _OWNER);
+    }
+
+    // Valid after the first parse, until arguments are added
+    inline const Config &defaults() const {
+        return _defaults;
+    }
+
+ private:
+    inline int _prepare(Config *config) {
+        const std::uint64_t hash = _parser->schemaHash();
+        if (!_defaults_valid || _defaults_hash != hash) {
+            _defaults = Config{};
+            int res = _parser->bindDefaults(&_defaults, _OWNER);
+            if (res) return res;
+            _defaults_valid = true;
+            _defaults_hash = hash;
+        }
+
+        *config = _defaults;
+        return 0;
+    }
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_BINDING_H_
@@ -0,0 +1,39 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_COMPLETION_H_
+#define CMDARG_COMPLETION_H_
+
+// System headers
+#include <string>
+
+namespace cmdarg::completion {
+
+enum class Shell {
+    BASH,
+    ZSH,
+    FISH,
+};
+
+// Hidden first argument recognized by Parser::parse: the following arguments
+// are the words of the command line up to the one under the cursor (the last
+// one, possibly empty); candidates are printed one per line and the program
+// exits without running any action.
+constexpr const char *REQUEST = "__cmdarg_complete";
+
+// Hidden first argument recognized by Parser::parse: prints the completion
+// script for the shell named by the following argument and exits.
+constexpr const char *SCRIPT_REQUEST = "__cmdarg_completion_script";
+
+// Returns the script that registers completion for prog in the given shell,
+// to be sourced from the shell itself, e.g.:
+//     eval "$(prog __cmdarg_completion_script bash)"
+extern std::string script(Shell shell, const std::string &prog);
+
+// Parses a shell name ("bash", "zsh" or "fish"), returns false if unknown
+extern bool shellFromName(const std::string &name, Shell *shell);
+
+}  // namespace cmdarg::completion
+
+#endif  // CMDARG_COMPLETION_H_
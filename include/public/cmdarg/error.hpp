@@ -0,0 +1,62 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_ERROR_H_
+#define CMDARG_ERROR_H_
+
+// System headers
+#include <string>
+#include <vector>
+
+namespace cmdarg {
+
+struct ParseError {
+    enum class Kind {
+        NONE = 0,
+        UNKNOWN_OPTION,
+        AMBIGUOUS_OPTION,
+        MISSING_PARAMETER,
+        UNEXPECTED_PARAMETER,
+        INVALID_VALUE,
+        TOO_MANY_ARGUMENTS,
+        MISSING_ARGUMENTS,
+        UNKNOWN_COMMAND,
+        INVALID_COMMAND_LINE,
+
+        // Only when help requests are refused, see Parser::setExitOnHelp
+        HELP_REQUESTED,
+
+        // An option of the selected subcommand has the name of an option of
+        // its parent, a mistake of the program rather than of the user
+        NAME_CONFLICT,
+
+        // The arena given to split a command string was too small, see
+        // tokenizer::scratchSize
+        ARENA_EXHAUSTED,
+    };
+
+    Kind kind = Kind::NONE;
+
+    // The offending command-line token (or value, for INVALID_VALUE)
+    std::string token;
+
+    // Closest valid alternatives to token, best first; for unknown options
+    // these are option names (with dashes), for invalid values the closest
+    // allowed choices
+    std::vector<std::string> suggestions;
+
+    inline explicit operator bool() const {
+        return kind != Kind::NONE;
+    }
+};
+
+// Called by the parser when parsing fails. When no handler is installed, the
+// parser prints the error on stderr and terminates the program; a handler
+// that returns makes parse() return instead, leaving the error available from
+// Parser::lastError().
+using ErrorHandler = void (*)(const ParseError &err);
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_ERROR_H_
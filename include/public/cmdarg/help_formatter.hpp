@@ -12,15 +12,18 @@
 
 // Project headers
 #include <cmdarg/argument.hpp>
+#include <cmdarg/subcommand.hpp>
 
 namespace cmdarg {
 
 class HelpFormatter {
  public:
+    // Every field has an initializer, so that designated initializers may
+    // leave any of them out (e.g. {.prog = argv[0]}) without warnings
     struct Params {
-        std::string prog;
-        std::string description;
-        std::string epilogue;
+        std::string prog = "";
+        std::string description = "";
+        std::string epilogue = "";
         int indent_base = 4;
         int indent_help = 32;
         int max_length = 80;
@@ -47,6 +50,8 @@ class HelpFormatter {
     virtual std::string _short_option(const Argument &arg) const;
     virtual std::string _long_option(const Argument &arg) const;
     virtual std::string _sl_option_separator(const Argument &arg) const;
+    virtual std::string _choices(const Argument &arg) const;
+    virtual std::string _env(const Argument &arg) const;
     virtual std::string _default(const Argument &arg) const;
     virtual std::string _description(const Argument &arg) const;
     // virtual std::string _full_help(const Argument &arg) const;
@@ -58,15 +63,48 @@ class HelpFormatter {
                               const std::vector<Argument> &required,
                               const std::vector<Argument> &optional) const;
 
+    // Same as above, ending with COMMAND when there are subcommands; without
+    // any, calls the one above
+    virtual void _formatUsage(
+        std::ostream *os, const std::vector<Argument> &required,
+        const std::vector<Argument> &optional,
+        const std::vector<Subcommand> &subcommands) const;
+
     virtual void _formatArgumentHelp(std::ostream *os,
                                      const Argument &arg) const;
 
+    virtual void _formatSubcommandHelp(std::ostream *os,
+                                       const Subcommand &cmd) const;
+
  public:
+    inline const Params &params() const {
+        return _params;
+    }
+
     virtual std::string metavar(const Argument &arg) const;
 
+    // Help of the given arguments only, in order (e.g. search results)
+    virtual void formatArguments(
+        std::ostream *os, const std::vector<const Argument *> &args) const;
+
     virtual void formatHelp(std::ostream *os,
                             const std::vector<Argument> &required,
                             const std::vector<Argument> &optional) const;
+
+    // Same as above, followed by the list of subcommands; without any, calls
+    // the one above, so overriding that one is enough for parsers without
+    // subcommands
+    virtual void formatHelp(std::ostream *os,
+                            const std::vector<Argument> &required,
+                            const std::vector<Argument> &optional,
+                            const std::vector<Subcommand> &subcommands) const;
+
+ private:
+    void _usage(std::ostream *os, const std::vector<Argument> &required,
+                const std::vector<Argument> &optional, bool commands) const;
+    void _help(std::ostream *os, const std::vector<Argument> &required,
+               const std::vector<Argument> &optional,
+               const std::vector<Subcommand> &subcommands) const;
 };
 
 class TerminalWrapHelpFormatter : public virtual HelpFormatter {
@@ -0,0 +1,145 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_LIVE_H_
+#define CMDARG_LIVE_H_
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Project headers
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+/*
+ * Live configuration: the result of parsing a command line, together with
+ * the environment and configuration file layers, published as an immutable
+ * snapshot that reload() replaces (e.g. on SIGHUP) while other threads keep
+ * reading.
+ *
+ * Every reader thread owns a Reader; pinning the current snapshot costs two
+ * loads and one store, with no locks, retries or reference counts, so reads
+ * never wait for reloads. A reload publishes the new snapshot at once, then
+ * waits for the readers still pinning the old one before freeing it (an
+ * epoch-based grace period); keep read sections short.
+ *
+ *     cmdarg::LiveOptions live{&parser, argc, argv};
+ *
+ *     // In each reader thread
+ *     cmdarg::LiveOptions::Reader reader{&live};
+ *     {
+ *         cmdarg::LiveOptions::ReadLock lock{&reader};
+ *         use(lock->at("count"));
+ *     }
+ *
+ *     // From a thread that noticed the SIGHUP (never the signal handler)
+ *     live.reload();
+ */
+class LiveOptions {
+    static constexpr std::uint64_t IDLE = ~0ULL;
+
+    // Epoch pinned by one reader, IDLE when it is not reading; slots are
+    // reused by later readers and freed only with this object
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{IDLE};
+        std::atomic<bool> used{true};
+        Slot *next = nullptr;
+    };
+
+    Parser *_parser;
+    std::vector<std::string> _args;
+    std::vector<char *> _argv;
+
+    std::atomic<const Options *> _current{nullptr};
+    std::atomic<std::uint64_t> _epoch{0};
+    std::atomic<Slot *> _slots{nullptr};
+
+    // Serializes reloads, readers never take it
+    std::mutex _reload_mutex;
+
+    void _publish(Options values);
+
+ public:
+    // Parses argv (kept for reloads) with parser, which must not be used
+    // by anything else from now on and must outlive this object
+    LiveOptions(Parser *parser, int argc, char *const argv[]);
+
+    // Frees the snapshot and the slots of the readers: every Reader must
+    // have been destroyed before (e.g. reader threads joined)
+    ~LiveOptions() noexcept;
+
+    LiveOptions(const LiveOptions &rhs) = delete;
+    LiveOptions &operator=(const LiveOptions &rhs) = delete;
+
+    // Reads the configuration file again and parses the same command line
+    // with it and the current environment. On failure the old snapshot
+    // stays published and nothing is terminated: returns -1 if the file
+    // cannot be read, the number of its first malformed line, or -2 if the
+    // values are not accepted (see Parser::lastError), help requests
+    // included.
+    int reload();
+
+    // Number of snapshots published so far, 1 after construction
+    inline std::uint64_t generation() const {
+        return _epoch.load(std::memory_order_acquire);
+    }
+
+    // Must be destroyed before the LiveOptions it reads, which owns its slot
+    class Reader {
+        LiveOptions *_live;
+        Slot *_slot;
+
+     public:
+        explicit Reader(LiveOptions *live);
+        ~Reader() noexcept;
+
+        Reader(const Reader &rhs) = delete;
+        Reader &operator=(const Reader &rhs) = delete;
+
+        // Pins the current snapshot until unlock(), do not nest
+        inline const Options &lock() {
+            const std::uint64_t epoch = _live->_epoch.load();
+            _slot->epoch.store(epoch);
+            return *_live->_current.load();
+        }
+
+        inline void unlock() {
+            _slot->epoch.store(IDLE, std::memory_order_release);
+        }
+    };
+
+    class ReadLock {
+        Reader *_reader;
+        const Options *_values;
+
+     public:
+        explicit ReadLock(Reader *reader)
+            : _reader(reader), _values(&reader->lock()) {
+        }
+
+        ~ReadLock() noexcept {
+            _reader->unlock();
+        }
+
+        ReadLock(const ReadLock &rhs) = delete;
+        ReadLock &operator=(const ReadLock &rhs) = delete;
+
+        inline const Options &operator*() const {
+            return *_values;
+        }
+
+        inline const Options *operator->() const {
+            return _values;
+        }
+    };
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_LIVE_H_
@@ -6,18 +6,52 @@
 #define CMDARG_PARSER_H_
 
 // System headers
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 // Project headers
 #include <cmdarg/argument.hpp>
+#include <cmdarg/error.hpp>
 #include <cmdarg/help_formatter.hpp>
+#include <cmdarg/subcommand.hpp>
+#include <cmdarg/tokenizer.hpp>
+#include <cmdarg/visitor.hpp>
 
 namespace cmdarg {
 
 using Options = std::map<std::string, std::string>;
 
+// Forward declarations
+class ParserImpl;
+class Session;
+namespace session {
+struct State;
+}  // namespace session
+
+// Where the value of an argument comes from, by increasing precedence
+enum class Source {
+    DEFAULT = 0,
+    CONFIG_FILE,
+    ENVIRONMENT,
+    COMMAND_LINE,
+};
+
+// Counters of the cache of parse results, see Parser::parseCached
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t entries = 0;
+
+    // Approximate memory taken by the entries
+    std::size_t bytes = 0;
+};
+
 class ParserInterface {
  public:
     virtual ~ParserInterface() noexcept = default;
@@ -29,37 +63,225 @@ class ParserInterface {
 };
 
 class Parser {
-    std::unique_ptr<ParserInterface> _impl;
+    std::unique_ptr<ParserImpl> _impl;
+
+    // Used by Session, see cmdarg/session.hpp
+    int _validate(session::State *state);
+    friend class Session;
+
+    // Parsers of subcommands are given the words of their parent as they are
+    friend class ParserImpl;
 
  public:
     explicit Parser(const HelpFormatter::Params &p);
     explicit Parser(const HelpFormatter &fmt);
 
-    ~Parser() noexcept = default;
+    ~Parser() noexcept;
 
     // Copy construction and assignment
     Parser(const Parser &rhs) = delete;
     Parser &operator=(const Parser &rhs) = delete;
 
     // Move construction and assignment
-    Parser(Parser &&rhs) = default;
-    Parser &operator=(Parser &&rhs) = default;
+    Parser(Parser &&rhs) noexcept;
+    Parser &operator=(Parser &&rhs) noexcept;
+
+    // All the strings of arg_options are copied, they do not need to outlive
+    // the call
+    int addArgument(const Argument &arg_options);
+
+    // Same as above for a whole table, checked at once for duplicate names
+    // (and registered only if there are none) and compiled once; see also
+    // cmdarg/registry.hpp
+    int addArguments(const Argument args[], std::size_t count);
+
+    // Subcommands take the place of required positional arguments: the first
+    // non-option word selects one, whose own parser is set up on demand and
+    // parses the rest of the command line. Its values are merged in the
+    // result, where "command" holds the path of the selected subcommand(s).
+    int addSubcommand(const Subcommand &cmd);
+
+    Options parse(int argc, char *const argv[]);
+
+    // Same as above, argv[0] is the program name
+    Options parse(int argc, const std::string_view argv[]);
+
+    // Parses a whole command string (without the program name), split as
+    // described in cmdarg/tokenizer.hpp; the words are kept in arena, which
+    // must hold at least tokenizer::scratchSize(cmdline.size()) bytes to
+    // never fail with ParseError::Kind::ARENA_EXHAUSTED. Completion
+    // requests are not recognized here, install an error handler to keep a
+    // failing command from terminating the program.
+    Options parse(std::string_view cmdline, Arena *arena);
+
+    /*
+     * Same as parse, through a cache of the results of past command lines
+     * (disabled until setCacheCapacity is called): when argv (program name
+     * aside) and the environment variables of the arguments are the same as
+     * in a cached parse, its result is shared instead of parsing again.
+     * Parsing is assumed to depend on nothing else: actions with side
+     * effects, and environment variables of subcommand arguments, are not
+     * seen on a hit.
+     *
+     * Only successful parses are cached. A parse served by the cache leaves
+     * source() and value() as they were, and lastError() clear. The cache
+     * is emptied whenever arguments, subcommands, schema or configuration
+     * change.
+     */
+    std::shared_ptr<const Options> parseCached(int argc, char *const argv[]);
+
+    // Same as above, argv[0] is the program name
+    std::shared_ptr<const Options> parseCached(int argc,
+                                               const std::string_view argv[]);
+
+    // Bounds the approximate memory of the cache used by parseCached,
+    // evicting the least recently used results; 0 (the default) disables it
+    void setCacheCapacity(std::size_t bytes);
+
+    CacheStats cacheStats() const;
+
+    // Parses only the long options of argv named "<name_space>.<name>"
+    // (or abbreviated, with their values), skipping every other word up to
+    // "--": for libraries reading their own options from the command line
+    // of the program (see cmdarg/process.hpp). With an empty name_space,
+    // the long options known to this parser (by their full names) are taken
+    // instead; --help never is.
+    Options parseNamespace(int argc, const std::string_view argv[],
+                           std::string_view name_space);
+
+    /*
+     * Streaming parse: instead of building the final values, calls visitor
+     * for every option and positional word as they come (see
+     * cmdarg/visitor.hpp). Values go through the actions of the arguments
+     * all the same, only the command line is visited (no configuration file
+     * or environment layers) and parsers with subcommands are not supported.
+     * Returns 0, the non-zero value returned by visitor if it stopped, -1 if
+     * the command line is invalid (after the error handler returns) or -2
+     * for parsers with subcommands.
+     */
+    int visit(int argc, char *const argv[], Visitor *visitor);
+
+    // Same as above, argv[0] is the program name
+    int visit(int argc, const std::string_view argv[], Visitor *visitor);
+
+    // Identifier of the argument with the given long name, as found in the
+    // events of visit, or NO_ARGUMENT; valid until arguments are added
+    std::uint32_t argumentId(std::string_view name);
+
+    /*
+     * Untyped layer of cmdarg::Binding (see cmdarg/binding.hpp), which
+     * should be used instead. bindDefaults converts the defaults of the
+     * arguments bound to members of the struct identified by owner into
+     * base. parseInto converts the defaults of the arguments bound to
+     * variables, then visits argv (see visit) storing each value into its
+     * destination as it comes.
+     * Return 0, -1 if the command line is invalid (or a value does not fit
+     * its field), -2 for parsers with subcommands, -3 if some argument is
+     * bound to a member of another struct, -4 if a default value does not
+     * fit its field.
+     */
+    int bindDefaults(void *base, const void *owner);
+
+    int parseInto(int argc, char *const argv[], void *base, const void *owner);
+
+    int parseInto(int argc, const std::string_view argv[], void *base,
+                  const void *owner);
+
+    void clear();
+
+    std::string getHelp() const;
+
+    // Help of the arguments whose name or help text matches term, best
+    // matches first, as printed by --help=TERM; the index behind it is built
+    // the first time
+    std::string searchHelp(const std::string &term) const;
+
+    // Returns the completion candidates for the last word in argv (argv[0]
+    // is ignored, as in parse)
+    std::vector<std::string> complete(int argc, char *const argv[]);
+
+    const ParseError &lastError() const;
+
+    void setErrorHandler(ErrorHandler handler);
+
+    ErrorHandler errorHandler() const;
+
+    // When false, help requests (e.g. --help, or any action returning a
+    // negative value) on the command line fail the parse with
+    // ParseError::Kind::HELP_REQUESTED instead of printing the help and
+    // terminating the program; true by default
+    void setExitOnHelp(bool exit);
+
+    bool exitOnHelp() const;
+
+    /*
+     * Compiled schemas: saveSchema writes the arguments registered so far,
+     * together with their lookup tables, help text and defaults, as a
+     * versioned binary blob. loadSchema and mapSchema replace all the
+     * arguments of the parser with such a blob, which is used in place,
+     * without any further registration work.
+     *
+     * Blobs passed to loadSchema must be aligned to 8 bytes and stay valid
+     * for the lifetime of the parser, e.g. an embedded array:
+     *     alignas(8) static const unsigned char schema[] = { ... };
+     * mapSchema maps the file and keeps it mapped for as long as needed.
+     *
+     * All of them return 0 on success, or: -1 for invalid data (or wrong
+     * alignment), -2 for an unsupported format version, -3 for a checksum
+     * mismatch, -4 for schemas using custom actions or subcommands (which
+     * cannot be saved), -5 for I/O errors.
+     */
+    int saveSchema(std::ostream *os);
+
+    int loadSchema(const void *data, std::size_t size);
+
+    int mapSchema(const std::string &path);
+
+    /*
+     * Layered configuration: each optional argument takes its value from the
+     * command line, or else from its environment variable (Argument::env),
+     * or else from the configuration file, or else from its default. Values
+     * from every layer go through the action of the argument, so they are
+     * checked like command-line ones; arguments without parameters accept
+     * booleans ("true", "no", ...) instead.
+     *
+     * loadConfig reads "key = value" lines (with # comments and quoted
+     * values) of an INI-like file, from the given [section] or from the top
+     * level if section is empty; subcommands read the section named after
+     * them, e.g. [run.fast]. Call it after registering the arguments: keys
+     * not naming one of them are ignored.
+     * Returns 0, -1 if the file cannot be read, or the number of the first
+     * malformed line.
+     */
+    int loadConfig(const std::string &path, const std::string &section = "");
+
+    // Reads again the file of the last loadConfig (if any), same results
+    int reloadConfig();
 
-    inline int addArgument(const Argument &arg_options) {
-        return _impl->addArgument(arg_options);
-    }
+    // Returns the layer of the value of name after the last parse
+    Source source(const std::string &name) const;
 
-    inline Options parse(int argc, char *const argv[]) {
-        return _impl->parse(argc, argv);
-    }
+    /*
+     * Returns in out the value of name after the last parse. Unlike the map
+     * returned by parse, where they are left to default_value, this also
+     * covers arguments with a default provider that were not set by any
+     * layer: the provider is called on the first read, and its result kept
+     * until the next parse. Providers may read other values, and a value
+     * depending on itself fails.
+     * Returns 0, -1 for unknown names, -2 for dependency cycles, or the
+     * non-zero result of a failing provider (which is called again on the
+     * next read).
+     */
+    int value(const std::string &name, std::string *out);
 
-    inline void clear() {
-        _impl->clear();
-    }
+    // Identifies the compiled schema: parsers with the same arguments (same
+    // names, help, defaults, ...) and subcommands have the same hash; all
+    // subcommands are set up to compute it
+    std::uint64_t schemaHash();
 
-    inline std::string getHelp() const {
-        return _impl->getHelp();
-    }
+    // Packs values, as returned by the last parse, and their sources in an
+    // image for other processes (see cmdarg/results.hpp)
+    int saveResults(const Options &values, std::string *out);
 };
 
 }  // namespace cmdarg
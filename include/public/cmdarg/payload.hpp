@@ -0,0 +1,78 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_PAYLOAD_H_
+#define CMDARG_PAYLOAD_H_
+
+// System headers
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace cmdarg {
+
+/*
+ * Value of an argument using actions::store_payload: "@path" stands for the
+ * content of the file at path, anything else for itself ("@@text" for
+ * "@text"). The file is mapped only when read() is first called, so payloads
+ * the program never reads cost no I/O at all; files that cannot be mapped
+ * (pipes, devices, e.g. "@/dev/stdin") are read into memory instead, up to
+ * the same limit.
+ *
+ *     cmdarg::Payload policy{values["policy"]};
+ *     std::string_view text;
+ *     if (policy.read(&text)) {
+ *         std::cerr << policy.error() << std::endl;
+ *     }
+ *
+ * Copies share the mapping, which stays valid as long as any of them (and
+ * any view returned by read) is in use; a Payload must not be read by more
+ * threads at once.
+ */
+class Payload {
+    std::string _value;
+    std::size_t _max_size;
+
+    // Content of the file, once mapped
+    mutable std::shared_ptr<const void> _mapping;
+    mutable std::string_view _content;
+    mutable bool _loaded = false;
+    mutable std::string _error;
+
+ public:
+    static constexpr std::size_t DEFAULT_MAX_SIZE = 64 << 20;
+
+    explicit Payload(std::string_view value,
+                     std::size_t max_size = DEFAULT_MAX_SIZE)
+        : _value(value), _max_size(max_size) {
+    }
+
+    // True if the value names a file
+    inline bool isFile() const {
+        return _value.size() > 1 && _value[0] == '@' && _value[1] != '@';
+    }
+
+    inline std::string path() const {
+        return isFile() ? _value.substr(1) : "";
+    }
+
+    // Sets *out to the content of the payload. Returns 0, or: -1 if the file
+    // cannot be opened, -2 if it is larger than max_size, -3 if it cannot be
+    // read, -5 if it cannot be mapped; failures are retried on the next call
+    int read(std::string_view *out) const;
+
+    // Describes the last failure of read, e.g.
+    //     cannot open '/etc/policy.json': No such file or directory
+    inline const std::string &error() const {
+        return _error;
+    }
+
+ private:
+    int _read_stream(int fd, const std::string &file) const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_PAYLOAD_H_
@@ -0,0 +1,43 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_PROCESS_H_
+#define CMDARG_PROCESS_H_
+
+// System headers
+#include <string_view>
+
+// Project headers
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg::process {
+
+/*
+ * The command line of the running process, for libraries that need their
+ * options before (or without) main handing argv to them, e.g. from static
+ * initializers:
+ *
+ *     cmdarg::Parser parser{{.prog = "libtrace"}};
+ *     parser.addArgument({.long_opt = "trace.level", ...});
+ *     auto values = cmdarg::process::parse(&parser, "trace");
+ *
+ * /proc/self/cmdline is read into a single buffer the first time any thread
+ * asks for it, once per process, and split in place: words are never
+ * copied, and every later call (from any library) shares them.
+ */
+
+// Sets *argv to the words of the command line, argv[0] first, and returns
+// their number; 0 if it cannot be read
+extern int arguments(const std::string_view **argv);
+
+// Parses the options of parser named "<name_space>.<name>" found on the
+// command line of the process, see Parser::parseNamespace. Errors never
+// terminate the program: unless parser has an error handler of its own,
+// they are only left in parser->lastError(), with the values parsed so far
+// returned; help requests fail with ParseError::Kind::HELP_REQUESTED
+extern Options parse(Parser *parser, std::string_view name_space);
+
+}  // namespace cmdarg::process
+
+#endif  // CMDARG_PROCESS_H_
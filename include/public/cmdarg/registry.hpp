@@ -0,0 +1,106 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_REGISTRY_H_
+#define CMDARG_REGISTRY_H_
+
+// System headers
+#include <cstddef>
+
+// Project headers
+#include <cmdarg/argument.hpp>
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+/*
+ * Options declared by each library (or translation unit) of a program, all
+ * added to one parser at once: every block is a constant table of arguments,
+ * linked into a process-wide list during static initialization (in its
+ * place in the order below, whatever order the linker runs them in) and
+ * merged only when a parser asks for them.
+ *
+ *     // net.cc
+ *     static const cmdarg::Argument net_options[] = {
+ *         {.long_opt = "port", .short_opt = 'p', .help = "Port"},
+ *         {.long_opt = "timeout", .help = "Timeout (s)"},
+ *     };
+ *     CMDARG_REGISTER_OPTIONS("net", net_options);    // --net.port ...
+ *
+ *     // main.cc
+ *     cmdarg::registry::apply(&parser);
+ *
+ * Blocks with a namespace prefix the names of their options with it and a
+ * dot (values are stored under the full name); pass nullptr for no prefix.
+ * The merged table is ordered by namespace, then as declared, so help shows
+ * the same order in every build.
+ */
+class OptionBlock {
+    const char *_name_space;
+    const Argument *_arguments;
+    std::size_t _count;
+    OptionBlock *_next = nullptr;
+
+ public:
+    // Links the block in the registry, both must have static storage
+    template <std::size_t N>
+    OptionBlock(const char *name_space, const Argument (&arguments)[N])
+        : _name_space(name_space), _arguments(arguments), _count(N) {
+        _link();
+    }
+
+    OptionBlock(const OptionBlock &rhs) = delete;
+    OptionBlock &operator=(const OptionBlock &rhs) = delete;
+
+    inline const char *nameSpace() const {
+        return _name_space;
+    }
+
+    inline const Argument *arguments() const {
+        return _arguments;
+    }
+
+    inline std::size_t count() const {
+        return _count;
+    }
+
+    // Block following this one in the merged table, nullptr for the last one
+    inline const OptionBlock *next() const {
+        return _next;
+    }
+
+ private:
+    void _link();
+};
+
+namespace registry {
+
+// Adds the options of every registered block to parser (with
+// Parser::addArguments, so nothing is added if any name is taken twice);
+// the blocks are merged the first time and reused by later calls
+extern int apply(Parser *parser);
+
+}  // namespace registry
+
+}  // namespace cmdarg
+
+#define CMDARG_CONCAT_(a, b) a##b
+#define CMDARG_CONCAT(a, b) CMDARG_CONCAT_(a, b)
+
+// Unique within a translation unit, even for blocks registered on the same
+// line (e.g. by another macro); __LINE__ where __COUNTER__ is missing
+#ifdef __COUNTER__
+#define CMDARG_UNIQUE_ID __COUNTER__
+#else
+#define CMDARG_UNIQUE_ID __LINE__
+#endif
+
+// Registers a static array of arguments, at namespace scope
+#define CMDARG_REGISTER_OPTIONS(name_space, arguments)                  \
+    static ::cmdarg::OptionBlock CMDARG_CONCAT(_cmdarg_options_,        \
+                                               CMDARG_UNIQUE_ID) {      \
+        name_space, arguments                                          \
+    }
+
+#endif  // CMDARG_REGISTRY_H_
@@ -0,0 +1,94 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_RESULTS_H_
+#define CMDARG_RESULTS_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+/*
+ * Parse results handed to other processes: Parser::saveResults packs a
+ * result set (values and their sources) in a position-independent image
+ * tagged with the schema hash of the parser, which a worker process reads in
+ * place through a ResultsView, without parsing anything again.
+ *
+ *     // Supervisor
+ *     std::string image;
+ *     parser.saveResults(values, &image);
+ *     int fd = cmdarg::results::toMemfd(image);    // inherited by children
+ *
+ *     // Worker, with a parser set up the same way
+ *     cmdarg::ResultsView results;
+ *     if (results.mapFd(fd, parser.schemaHash()) == 0)
+ *         use(results.get("count"));
+ *
+ * All functions returning int return 0 on success, or: -1 for invalid data
+ * (or wrong alignment), -2 for an unsupported format version, -3 for a
+ * checksum mismatch, -4 for results of a different schema, -5 for I/O
+ * errors.
+ */
+class ResultsView {
+    // Keeps mapped or decoded images alive, shared among copies
+    std::shared_ptr<const void> _storage;
+    const char *_base = nullptr;
+
+ public:
+    ResultsView() = default;
+
+    // Images passed to open must be aligned to 8 bytes and outlive the view
+    int open(const void *data, std::size_t size, std::uint64_t schema_hash);
+
+    // Maps the whole file (e.g. a memfd), which can be closed afterwards
+    int mapFd(int fd, std::uint64_t schema_hash);
+
+    // Decodes the image stored by results::toEnv
+    int fromEnv(const char *name, std::uint64_t schema_hash);
+
+    inline bool empty() const {
+        return _base == nullptr;
+    }
+
+    std::size_t size() const;
+
+    // Entries are sorted by key; values are whole, even if they hold NUL
+    // bytes
+    std::string_view key(std::size_t index) const;
+    std::string_view value(std::size_t index) const;
+    Source source(std::size_t index) const;
+
+    // Returns the value of key, nullptr if there is none; values are
+    // NUL-terminated, use value() for the ones that may hold NUL bytes
+    const char *get(std::string_view key) const;
+
+    // Copies all the values, as returned by Parser::parse
+    Options toOptions() const;
+
+ private:
+    std::size_t _find(std::string_view key) const;
+};
+
+namespace results {
+
+// Returns a sealed, read-only memfd holding image, inherited across exec,
+// or -5 on errors
+extern int toMemfd(const std::string &image);
+
+// Stores image, base64-encoded, in the environment variable name
+extern int toEnv(const char *name, const std::string &image);
+
+}  // namespace results
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_RESULTS_H_
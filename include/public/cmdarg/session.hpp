@@ -0,0 +1,95 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_SESSION_H_
+#define CMDARG_SESSION_H_
+
+// System headers
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/error.hpp>
+#include <cmdarg/parser.hpp>
+
+namespace cmdarg {
+
+// Forward declaration
+namespace session {
+struct State;
+}  // namespace session
+
+// Error of a session, found at token position (the number of tokens for
+// errors about the end of the line, e.g. missing arguments)
+struct TokenError {
+    std::size_t position;
+    ParseError error;
+};
+
+/*
+ * Command line being edited, e.g. in an interactive shell that highlights
+ * errors as the user types: the caller reports each edit of the words of the
+ * line (without the program name), and validate() checks again only what
+ * the edits may have changed.
+ *
+ *     cmdarg::Session session{&parser};
+ *     session.insert(0, "--count");
+ *     session.insert(1, "1");
+ *     session.replace(1, "12x");
+ *     if (session.validate()) highlight(session.errors());
+ *
+ * What each word means as an option (lookup, clusters of short options,
+ * values after '=') is kept between validations, and so is the result of
+ * converting it as a value; only edited words are looked up and converted
+ * again, plus the words whose role the edit changed (e.g. the value of an
+ * option that was inserted before it, or positional arguments after an
+ * inserted one). Positional arguments, values of the options and the
+ * arguments still missing are checked again on every call, without any
+ * lookup or conversion, so long lines cost little per keystroke.
+ *
+ * Errors are the same a parse would report, with their position, except
+ * that every word is checked (a parse stops at the first error) and that
+ * they carry no suggestions. Help requests are not errors. Predefined
+ * actions are quiet while validating (see actions::setQuiet); custom
+ * actions must not print anything nor have other side effects, as they run
+ * on every keystroke. Parsers with subcommands are not supported.
+ */
+class Session {
+    Parser *_parser;
+    std::unique_ptr<session::State> _state;
+
+ public:
+    // The parser must outlive the session; arguments may still be added to
+    // it, every word is then checked again
+    explicit Session(Parser *parser);
+    ~Session() noexcept;
+
+    Session(const Session &rhs) = delete;
+    Session &operator=(const Session &rhs) = delete;
+
+    // Replaces the whole line
+    void assign(int count, const std::string_view tokens[]);
+
+    // Edits of single words, which are copied; all return 0, or -1 if index
+    // is out of range
+    int insert(std::size_t index, std::string_view token);
+    int remove(std::size_t index);
+    int replace(std::size_t index, std::string_view token);
+
+    std::size_t size() const;
+    std::string_view token(std::size_t index) const;
+
+    // Checks the line after the edits so far, returns the number of errors
+    // (0 if the line is valid) or -2 for parsers with subcommands
+    int validate();
+
+    // Errors found by the last validate, by position
+    const std::vector<TokenError> &errors() const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_SESSION_H_
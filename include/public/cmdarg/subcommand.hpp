@@ -0,0 +1,29 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_SUBCOMMAND_H_
+#define CMDARG_SUBCOMMAND_H_
+
+namespace cmdarg {
+
+// Forward declaration
+class Parser;
+
+struct Subcommand {
+ private:
+    using SetupType = void (*)(Parser *parser);
+
+ public:
+    const char *name;
+    const char *help = "";
+
+    // Registers the arguments (and nested subcommands) of the subcommand on
+    // its own parser; it is called only when the subcommand is selected on
+    // the command line (or completed by the shell)
+    const SetupType setup = nullptr;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_SUBCOMMAND_H_
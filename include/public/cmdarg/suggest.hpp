@@ -0,0 +1,70 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_SUGGEST_H_
+#define CMDARG_SUGGEST_H_
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cmdarg {
+
+// Returns the Levenshtein distance between a and b, or max_distance + 1 if it
+// is larger than max_distance (computation stops as soon as that is known).
+extern int editDistance(std::string_view a, std::string_view b,
+                        int max_distance);
+
+// Index over a set of names (long options, choice values, ...) used to find
+// the closest matches to a misspelled one ("did you mean ...?").
+//
+// Names are kept in a single buffer and visited in lexicographic order, which
+// walks them like a trie: the edit distance of the query against a name is
+// computed one character at a time with a bit-parallel (Myers) algorithm and
+// the state of the shared prefix is reused by the following names. Whenever a
+// prefix is already too far from the query, all the names sharing it are
+// skipped at once.
+class SuggestionIndex {
+    struct Entry {
+        std::uint32_t offset;
+        std::uint32_t length;
+        std::uint32_t order;
+    };
+
+    std::string _buffer;
+    std::vector<Entry> _entries;
+
+    // Entries in lexicographic order and the length of the common prefix of
+    // each one with the previous
+    mutable std::vector<Entry> _sorted;
+    mutable std::vector<std::uint32_t> _lcp;
+    mutable bool _dirty = false;
+
+ public:
+    SuggestionIndex() = default;
+    explicit SuggestionIndex(const char *const *names);
+
+    void add(std::string_view name);
+    void clear();
+
+    inline std::size_t size() const {
+        return _entries.size();
+    }
+
+    // Returns up to max_results names within max_distance edits from the
+    // query, closest first (ties are kept in insertion order). A negative
+    // max_distance selects a threshold based on the length of the query.
+    std::vector<std::string> suggest(std::string_view query,
+                                     int max_distance = -1,
+                                     std::size_t max_results = 3) const;
+
+ private:
+    void _build() const;
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_SUGGEST_H_
@@ -0,0 +1,69 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_TOKENIZER_H_
+#define CMDARG_TOKENIZER_H_
+
+// System headers
+#include <cstddef>
+#include <string_view>
+
+namespace cmdarg {
+
+// Scratch memory supplied by the caller, e.g. a buffer on the stack reused
+// for every command; nothing is ever freed until reset()
+class Arena {
+    char *_data;
+    std::size_t _capacity;
+    std::size_t _used = 0;
+
+ public:
+    Arena(void *data, std::size_t capacity)
+        : _data(static_cast<char *>(data)), _capacity(capacity) {
+    }
+
+    // Returns nullptr if the arena is exhausted
+    void *allocate(std::size_t size, std::size_t alignment);
+
+    inline void reset() {
+        _used = 0;
+    }
+
+    inline std::size_t used() const {
+        return _used;
+    }
+
+    inline std::size_t capacity() const {
+        return _capacity;
+    }
+};
+
+namespace tokenizer {
+
+/*
+ * Splits a command string into words the way a POSIX shell does, without
+ * any expansion: words are separated by unquoted blanks and newlines,
+ * backslash escapes the next character (a backslash-newline pair is
+ * removed), single quotes keep everything literally, double quotes keep
+ * everything but \" \\ \$ \` and backslash-newline, and an unquoted # at
+ * the start of a word comments out the rest of the line. '$' and '`' are
+ * never expanded.
+ *
+ * The array of words is allocated in arena; words that contain quotes or
+ * escapes are unquoted in arena as well, all the others point into cmdline.
+ * Returns 0, -1 if a quote is not closed (or cmdline ends with a
+ * backslash), -2 if arena is too small.
+ */
+extern int split(std::string_view cmdline, Arena *arena,
+                 const std::string_view **words, std::size_t *count);
+
+// Size of an arena large enough to split any command string of the given
+// length, from an empty arena
+extern std::size_t scratchSize(std::size_t size);
+
+}  // namespace tokenizer
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_TOKENIZER_H_
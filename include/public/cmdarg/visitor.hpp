@@ -0,0 +1,65 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_VISITOR_H_
+#define CMDARG_VISITOR_H_
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cmdarg {
+
+// Identifier of positional words beyond the required arguments
+constexpr std::uint32_t NO_ARGUMENT = ~0U;
+
+// One occurrence of an argument on the command line, valid only during the
+// call that receives it
+struct Event {
+    // As returned by Parser::argumentId, NO_ARGUMENT for extra positionals
+    std::uint32_t id;
+
+    // Long name of the argument, empty for extra positionals
+    std::string_view name;
+
+    // As given on the command line, empty for options without one
+    std::string_view value;
+
+    // Value of the argument after this occurrence, as parse would store it:
+    // the action is applied to the value so far (the default on the first
+    // occurrence), so increments count occurrences; same as value for extra
+    // positionals
+    std::string_view converted;
+
+    // Index in argv of the word naming the option (or of the positional),
+    // argv[0] being the program name
+    std::size_t position;
+};
+
+/*
+ * Receives the arguments of Parser::visit one at a time, in command line
+ * order, instead of a map of final values: memory stays the same however
+ * long the command line is, e.g. for edit scripts like
+ *     tool --add X --remove Y --add Z ...
+ * Returning non-zero from a callback stops the parse, and visit returns that
+ * value.
+ */
+class Visitor {
+ public:
+    virtual ~Visitor() noexcept = default;
+
+    virtual int onOption(const Event & /*event*/) {
+        return 0;
+    }
+
+    // Positional words, bound to the required arguments in order
+    virtual int onPositional(const Event & /*event*/) {
+        return 0;
+    }
+};
+
+}  // namespace cmdarg
+
+#endif  // CMDARG_VISITOR_H_
@@ -11,6 +11,9 @@
 
 namespace cmdarg::actions {
 
+// See setQuiet
+static thread_local bool _quiet = false;
+
 template <class T>
 using check_type = bool (*)(const T &v);
 
@@ -79,6 +82,8 @@ int store_number(std::string *dest, const Argument &opt, const std::string &src,
     }
 
 error:
+    if (_quiet) return 1;
+
     std::cerr << "Error: argument ";
     if (opt.short_opt) {
         std::cerr << opt.short_opt << "/";
@@ -153,6 +158,54 @@ int store_string(std::string *dest, const Argument &opt,
     return 0;
 }
 
+int store_choice(std::string *dest, const Argument &opt,
+                 const std::string &src) {
+    if (opt.choices) {
+        for (auto choice = opt.choices; *choice; ++choice) {
+            if (src == *choice) {
+                *dest = src;
+                return 0;
+            }
+        }
+    }
+
+    if (_quiet) return 1;
+
+    std::cerr << "Error: argument ";
+    if (opt.short_opt) {
+        std::cerr << opt.short_opt << "/";
+    }
+
+    std::cerr << opt.long_opt << ": ";
+    std::cerr << "invalid choice: '" << src << "' (choose from";
+    for (auto choice = opt.choices; choice && *choice; ++choice) {
+        std::cerr << ((choice == opt.choices) ? " '" : ", '") << *choice
+                  << "'";
+    }
+    std::cerr << ")" << std::endl;
+    return 1;
+}
+
+int store_payload(std::string *dest, const Argument &opt,
+                  const std::string &src) {
+    // Files are not even looked at here, only when the value is read
+    if (src != "@") {
+        *dest = src;
+        return 0;
+    }
+
+    if (_quiet) return 1;
+
+    std::cerr << "Error: argument ";
+    if (opt.short_opt) {
+        std::cerr << opt.short_opt << "/";
+    }
+
+    std::cerr << opt.long_opt << ": ";
+    std::cerr << "missing file name after '@'" << std::endl;
+    return 1;
+}
+
 int store_bool(std::string *dest, bool value) {
     *dest = value ? "true" : "false";
     return 0;
@@ -231,4 +284,85 @@ const Type increment_long_long = increment_number<long long>;
 const Type increment_float = increment_number<float>;
 const Type increment_double = increment_number<double>;
 
+/*
+ * ┌───────────────────────────────────────────────┐
+ * │              Predefined Actions               │
+ * └───────────────────────────────────────────────┘
+ */
+
+// Identifiers are indices in this table: only append to it, compiled schemas
+// refer to actions by position
+static const Type _PREDEFINED[] = {
+    store_string,
+    store_true,
+    store_false,
+    store_choice,
+    show_help_and_exit,
+
+    store_number_nocheck<int, stoi>,
+    store_number_nocheck<long, stol>,
+    store_number_nocheck<long long, stoll>,
+    store_number_nocheck<float, stof>,
+    store_number_nocheck<double, stod>,
+
+    store_number_positive<int, stoi>,
+    store_number_positive<long, stol>,
+    store_number_positive<long long, stoll>,
+    store_number_positive<float, stof>,
+    store_number_positive<double, stod>,
+
+    store_number_negative<int, stoi>,
+    store_number_negative<long, stol>,
+    store_number_negative<long long, stoll>,
+    store_number_negative<float, stof>,
+    store_number_negative<double, stod>,
+
+    store_number_nonpositive<int, stoi>,
+    store_number_nonpositive<long, stol>,
+    store_number_nonpositive<long long, stoll>,
+    store_number_nonpositive<float, stof>,
+    store_number_nonpositive<double, stod>,
+
+    store_number_nonnegative<int, stoi>,
+    store_number_nonnegative<long, stol>,
+    store_number_nonnegative<long long, stoll>,
+    store_number_nonnegative<float, stof>,
+    store_number_nonnegative<double, stod>,
+
+    store_number_nonzero<int, stoi>,
+    store_number_nonzero<long, stol>,
+    store_number_nonzero<long long, stoll>,
+    store_number_nonzero<float, stof>,
+    store_number_nonzero<double, stod>,
+
+    increment_number<int>,
+    increment_number<long>,
+    increment_number<long long>,
+    increment_number<float>,
+    increment_number<double>,
+
+    store_payload,
+};
+
+static constexpr int _PREDEFINED_COUNT =
+    sizeof(_PREDEFINED) / sizeof(_PREDEFINED[0]);
+
+int predefinedId(Type action) {
+    for (int id = 0; id < _PREDEFINED_COUNT; ++id) {
+        if (_PREDEFINED[id] == action) return id;
+    }
+    return -1;
+}
+
+Type predefined(int id) {
+    if (id < 0 || id >= _PREDEFINED_COUNT) return nullptr;
+    return _PREDEFINED[id];
+}
+
+bool setQuiet(bool quiet) {
+    const bool previous = _quiet;
+    _quiet = quiet;
+    return previous;
+}
+
 }  // namespace cmdarg::actions
@@ -0,0 +1,45 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/classify.hpp>
+
+namespace cmdarg::classify {
+
+// Only the kinds must be already there
+static void _find_equals(std::size_t count, const std::string_view tokens[],
+                         Table *table) {
+    table->equals.assign(count, NONE);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (table->kinds[i] != LONG) continue;
+
+        // memchr is vectorized already; tokens come from argv (or from a
+        // command string), so they are way shorter than 4 GiB
+        const std::string_view token = tokens[i];
+        const void *equal =
+            std::memchr(token.data() + 2, '=', token.size() - 2);
+        if (equal != nullptr) {
+            table->equals[i] =
+                static_cast<const char *>(equal) - token.data();
+        }
+    }
+}
+
+void build(std::size_t count, const std::string_view tokens[],
+           Table *table) {
+    table->kinds.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        table->kinds[i] = kindOf(tokens[i]);
+    }
+
+    _find_equals(count, tokens, table);
+}
+
+}  // namespace cmdarg::classify
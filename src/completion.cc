@@ -0,0 +1,103 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cctype>
+#include <string>
+
+// Project headers
+#include <cmdarg/completion.hpp>
+
+namespace cmdarg::completion {
+
+// Bash splits the word under the cursor at '=' (COMP_WORDBREAKS), so the
+// command line is split again by hand and the part of each candidate that
+// bash already considers typed is removed.
+static const char _BASH_SCRIPT[] = R"(_cmdarg_@ID@() {
+    local line="${COMP_LINE:0:COMP_POINT}"
+    local -a words
+    read -r -a words <<< "${line}"
+    [[ "${line}" =~ [[:space:]]$ ]] && words+=("")
+
+    local cur="${words[${#words[@]}-1]}"
+    local IFS=$'\n'
+    COMPREPLY=($("${words[0]}" @REQUEST@ "${words[@]:1}" 2>/dev/null))
+
+    if [[ "${cur}" == *=* && "${COMP_WORDBREAKS}" == *=* ]]; then
+        COMPREPLY=("${COMPREPLY[@]#*=}")
+    fi
+}
+complete -o default -F _cmdarg_@ID@ @PROG@
+)";
+
+static const char _ZSH_SCRIPT[] = R"(#compdef @PROG@
+_cmdarg_@ID@() {
+    local -a candidates
+    candidates=("${(@f)$("${words[1]}" @REQUEST@ "${(@)words[2,CURRENT]}" 2>/dev/null)}")
+
+    if (( ${#candidates} )) && [[ -n "${candidates[1]}" ]]; then
+        compadd -Q -- "${candidates[@]}"
+    else
+        _files
+    fi
+}
+compdef _cmdarg_@ID@ @PROG@
+)";
+
+static const char _FISH_SCRIPT[] = R"(function __cmdarg_@ID@
+    set -l tokens (commandline -opc) (commandline -ct)
+    $tokens[1] @REQUEST@ $tokens[2..-1] 2>/dev/null
+end
+complete -c @PROG@ -a '(__cmdarg_@ID@)'
+)";
+
+static void _replace_all(std::string *s, const std::string &from,
+                         const std::string &to) {
+    for (auto pos = s->find(from); pos != std::string::npos;
+         pos = s->find(from, pos + to.length())) {
+        s->replace(pos, from.length(), to);
+    }
+}
+
+std::string script(Shell shell, const std::string &prog) {
+    std::string out;
+    switch (shell) {
+        case Shell::BASH:
+            out = _BASH_SCRIPT;
+            break;
+        case Shell::ZSH:
+            out = _ZSH_SCRIPT;
+            break;
+        case Shell::FISH:
+            out = _FISH_SCRIPT;
+            break;
+    }
+
+    // Shells complete on the command name, not on the path used to run it
+    std::string name = prog.substr(prog.find_last_of('/') + 1);
+
+    std::string id = name;
+    for (auto &c : id) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+    }
+
+    _replace_all(&out, "@ID@", id);
+    _replace_all(&out, "@PROG@", name);
+    _replace_all(&out, "@REQUEST@", REQUEST);
+    return out;
+}
+
+bool shellFromName(const std::string &name, Shell *shell) {
+    if (name == "bash") {
+        *shell = Shell::BASH;
+    } else if (name == "zsh") {
+        *shell = Shell::ZSH;
+    } else if (name == "fish") {
+        *shell = Shell::FISH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace cmdarg::completion
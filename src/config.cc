@@ -0,0 +1,201 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/config.hpp>
+
+namespace cmdarg::config {
+
+static inline bool _is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static std::string_view _trim(std::string_view s) {
+    while (s.size() && _is_space(s.front())) s.remove_prefix(1);
+    while (s.size() && _is_space(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// True if s holds nothing but (possibly) a comment
+static inline bool _is_blank(std::string_view s) {
+    s = _trim(s);
+    return s.empty() || s[0] == '#' || s[0] == ';';
+}
+
+static bool _unquote(std::string_view raw, std::string *out) {
+    out->clear();
+
+    if (raw.size() && raw[0] == '\'') {
+        std::size_t close = raw.find('\'', 1);
+        if (close == std::string_view::npos) return false;
+        out->assign(raw.substr(1, close - 1));
+        return _is_blank(raw.substr(close + 1));
+    }
+
+    if (raw.size() && raw[0] == '"') {
+        for (std::size_t i = 1; i < raw.size(); ++i) {
+            char c = raw[i];
+            if (c == '"') return _is_blank(raw.substr(i + 1));
+            if (c == '\\') {
+                if (++i == raw.size()) return false;
+                switch (raw[i]) {
+                    case '"':
+                    case '\\':
+                        c = raw[i];
+                        break;
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    default:
+                        return false;
+                }
+            }
+            out->push_back(c);
+        }
+        return false;
+    }
+
+    // Bare values end at a comment starting after some whitespace
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        if ((raw[i] == '#' || raw[i] == ';') &&
+            (i == 0 || _is_space(raw[i - 1]))) {
+            raw = raw.substr(0, i);
+            break;
+        }
+    }
+    out->assign(_trim(raw));
+    return true;
+}
+
+int read(const char *data, std::size_t size, std::string_view section,
+         const schema::View &schema, std::vector<Value> *out) {
+    const char *p = data;
+    const char *end = data + size;
+    bool selected = section.empty();
+    std::string value;
+
+    // Position in out of the value of each record plus one, 0 if it has
+    // none yet: later lines replace earlier ones
+    std::vector<std::uint32_t> slots(schema.optionalCount() +
+                                     schema.requiredCount());
+    for (std::size_t i = 0; i < out->size(); ++i) {
+        const std::uint32_t index = schema.findLong((*out)[i].first);
+        if (index != schema::NONE) slots[index] = i + 1;
+    }
+
+    for (int line = 1; p < end; ++line) {
+        const char *eol =
+            static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (eol == nullptr) eol = end;
+
+        std::string_view l = _trim({p, static_cast<std::size_t>(eol - p)});
+        p = (eol < end) ? eol + 1 : end;
+
+        if (_is_blank(l)) continue;
+
+        if (l[0] == '[') {
+            std::size_t close = l.find(']');
+            if (close == std::string_view::npos) return line;
+
+            std::string_view name = _trim(l.substr(1, close - 1));
+            if (name.empty() || !_is_blank(l.substr(close + 1))) return line;
+
+            selected = (name == section);
+            continue;
+        }
+
+        std::size_t equal = l.find('=');
+        if (equal == std::string_view::npos) return line;
+
+        std::string_view key = _trim(l.substr(0, equal));
+        if (key.empty()) return line;
+
+        // Keys of other sections or programs are not even unquoted
+        if (!selected) continue;
+        const std::uint32_t index = schema.findLong(key);
+        if (index == schema::NONE) continue;
+
+        if (!_unquote(_trim(l.substr(equal + 1)), &value)) return line;
+
+        if (slots[index]) {
+            (*out)[slots[index] - 1].second = value;
+        } else {
+            out->emplace_back(std::string(key), value);
+            slots[index] = out->size();
+        }
+    }
+
+    return 0;
+}
+
+int load(const std::string &path, std::string_view section,
+         const schema::View &schema, std::vector<Value> *out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    std::size_t size = st.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    // The file is read once, front to back
+    ::madvise(data, size, MADV_SEQUENTIAL);
+
+    int res = read(static_cast<const char *>(data), size, section, schema, out);
+    ::munmap(data, size);
+    return res;
+}
+
+bool parseBool(std::string_view value, bool *out) {
+    static const char *const truthy[] = {"true", "yes", "on", "1"};
+    static const char *const falsy[] = {"false", "no", "off", "0"};
+
+    auto equals = [value](const char *word) {
+        if (std::strlen(word) != value.size()) return false;
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            char c = value[i];
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            if (c != word[i]) return false;
+        }
+        return true;
+    };
+
+    for (const char *word : truthy) {
+        if (equals(word)) return *out = true;
+    }
+    for (const char *word : falsy) {
+        if (equals(word)) {
+            *out = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace cmdarg::config
@@ -99,15 +99,34 @@ std::string HelpFormatter::_sl_option_separator(const Argument &arg) const {
 //     return _long;
 // }
 
+std::string HelpFormatter::_choices(const Argument &arg) const {
+    if (!arg.choices || !*arg.choices) return "";
+
+    std::string out = " (choices:";
+    for (auto choice = arg.choices; *choice; ++choice) {
+        out += ((choice == arg.choices) ? " " : ", ") + std::string(*choice);
+    }
+    return out + ")";
+}
+
+std::string HelpFormatter::_env(const Argument &arg) const {
+    if (!arg.env || !*arg.env) return "";
+
+    return " (env: " + std::string(arg.env) + ")";
+}
+
 std::string HelpFormatter::_default(const Argument &arg) const {
     if (arg.required) return "";
     if (arg.parameter_required == Argument::ParameterRequired::NO) return "";
 
+    // Never evaluated just to show the help
+    if (arg.default_provider) return " (default: computed)";
+
     return " (default: '" + std::string(arg.default_value) + "')";
 }
 
 std::string HelpFormatter::_description(const Argument &arg) const {
-    return std::string(arg.help) + _default(arg);
+    return std::string(arg.help) + _choices(arg) + _env(arg) + _default(arg);
 }
 
 template <class StringIt>
@@ -157,7 +176,7 @@ void HelpFormatter::_formatArgumentHelp(std::ostream *os,
                                       _params.max_length - _params.indent_help);
 
     std::string next_indent = indent_arg;
-    for (const auto token : argument_format) {
+    for (const auto &token : argument_format) {
         *os << next_indent << token;
         next_indent = _newline() + indent_arg;
     }
@@ -171,7 +190,7 @@ void HelpFormatter::_formatArgumentHelp(std::ostream *os,
         next_indent = indent_help;
     }
 
-    for (const auto token : description) {
+    for (const auto &token : description) {
         *os << next_indent << token << std::endl;
         next_indent = indent_help;
     }
@@ -180,6 +199,24 @@ void HelpFormatter::_formatArgumentHelp(std::ostream *os,
 void HelpFormatter::_formatUsage(std::ostream *os,
                                  const std::vector<Argument> &required,
                                  const std::vector<Argument> &optional) const {
+    _usage(os, required, optional, false);
+}
+
+void HelpFormatter::_formatUsage(
+    std::ostream *os, const std::vector<Argument> &required,
+    const std::vector<Argument> &optional,
+    const std::vector<Subcommand> &subcommands) const {
+    if (subcommands.empty()) {
+        _formatUsage(os, required, optional);
+    } else {
+        _usage(os, required, optional, true);
+    }
+}
+
+void HelpFormatter::_usage(std::ostream *os,
+                           const std::vector<Argument> &required,
+                           const std::vector<Argument> &optional,
+                           bool commands) const {
     std::string usage_prog = "usage: " + _params.prog;
     std::string next_indent;
 
@@ -199,27 +236,58 @@ void HelpFormatter::_formatUsage(std::ostream *os,
     }
 
     std::vector<std::string> full_arguments;
-    for (const auto arg : optional) {
+    for (const auto &arg : optional) {
         full_arguments.emplace_back(_usage_opt_option(arg));
     }
-    for (const auto arg : required) {
+    for (const auto &arg : required) {
         full_arguments.emplace_back(_usage_req_option(arg));
     }
+    if (commands) {
+        full_arguments.emplace_back("COMMAND");
+        full_arguments.emplace_back("...");
+    }
 
     full_arguments =
         formatWrappedTokens(full_arguments.cbegin(), full_arguments.cend(),
                             _params.max_length - indent_len);
 
-    for (const auto token : full_arguments) {
+    for (const auto &token : full_arguments) {
         *os << next_indent << token << std::endl;
         next_indent = usage_indent;
     }
 }
 
+void HelpFormatter::_formatSubcommandHelp(std::ostream *os,
+                                          const Subcommand &cmd) const {
+    std::string indent_arg = std::string(_params.indent_base, ' ');
+    std::string indent_help = std::string(_params.indent_help, ' ');
+
+    std::vector<std::string> description = _tokenize(cmd.help);
+    description = formatWrappedTokens(description.cbegin(), description.cend(),
+                                      _params.max_length - _params.indent_help);
+
+    *os << indent_arg << cmd.name;
+
+    std::string next_indent;
+    int remaining = (_params.indent_help - _params.indent_base) -
+                    std::string(cmd.name).length();
+    if (remaining > 0) {
+        next_indent = std::string(remaining, ' ');
+    } else {
+        *os << std::endl;
+        next_indent = indent_help;
+    }
+
+    for (const auto &token : description) {
+        *os << next_indent << token << std::endl;
+        next_indent = indent_help;
+    }
+}
+
 void printWrappedNoIndent(std::ostream *os, const std::string &str, int len) {
     std::vector tokens = _tokenize(str);
     tokens = formatWrappedTokens(tokens.cbegin(), tokens.cend(), len);
-    for (const auto token : tokens) {
+    for (const auto &token : tokens) {
         *os << token << std::endl;
     }
 }
@@ -241,7 +309,25 @@ void HelpFormatter::_formatEpilogue(std::ostream *os) const {
 void HelpFormatter::formatHelp(std::ostream *os,
                                const std::vector<Argument> &required,
                                const std::vector<Argument> &optional) const {
-    _formatUsage(os, required, optional);
+    _help(os, required, optional, {});
+}
+
+void HelpFormatter::formatHelp(
+    std::ostream *os, const std::vector<Argument> &required,
+    const std::vector<Argument> &optional,
+    const std::vector<Subcommand> &subcommands) const {
+    if (subcommands.empty()) {
+        formatHelp(os, required, optional);
+    } else {
+        _help(os, required, optional, subcommands);
+    }
+}
+
+void HelpFormatter::_help(std::ostream *os,
+                          const std::vector<Argument> &required,
+                          const std::vector<Argument> &optional,
+                          const std::vector<Subcommand> &subcommands) const {
+    _formatUsage(os, required, optional, subcommands);
     // *os << std::endl;
 
     _formatDescription(os);
@@ -249,7 +335,7 @@ void HelpFormatter::formatHelp(std::ostream *os,
     if (required.size()) {
         *os << std::endl;
         *os << "Required positional arguments:" << std::endl;
-        for (const auto arg : required) {
+        for (const auto &arg : required) {
             _formatArgumentHelp(os, arg);
         }
     }
@@ -257,14 +343,29 @@ void HelpFormatter::formatHelp(std::ostream *os,
     if (optional.size()) {
         *os << std::endl;
         *os << "Optional arguments:" << std::endl;
-        for (const auto arg : optional) {
+        for (const auto &arg : optional) {
             _formatArgumentHelp(os, arg);
         }
     }
 
+    if (subcommands.size()) {
+        *os << std::endl;
+        *os << "Commands:" << std::endl;
+        for (const auto &cmd : subcommands) {
+            _formatSubcommandHelp(os, cmd);
+        }
+    }
+
     _formatEpilogue(os);
 }
 
+void HelpFormatter::formatArguments(
+    std::ostream *os, const std::vector<const Argument *> &args) const {
+    for (const auto *arg : args) {
+        _formatArgumentHelp(os, *arg);
+    }
+}
+
 TerminalWrapHelpFormatter::TerminalWrapHelpFormatter(const Params &p)
     : HelpFormatter(p) {
     ::winsize window_size;
@@ -0,0 +1,166 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Project headers
+#include <cmdarg/help_index.hpp>
+
+namespace cmdarg {
+
+static constexpr std::uint32_t NO_MATCH = ~0U;
+
+static std::string _lower(std::string_view s) {
+    std::string out{s};
+    for (auto &c : out) {
+        c = std::tolower(static_cast<unsigned char>(c));
+    }
+    return out;
+}
+
+// Calls f on each maximal run of letters and digits of s, lowercase
+template <typename F>
+static void _split(std::string_view s, F f) {
+    std::size_t i = 0;
+    while (i < s.size()) {
+        while (i < s.size() && !std::isalnum(static_cast<unsigned char>(s[i])))
+            ++i;
+
+        std::size_t begin = i;
+        while (i < s.size() && std::isalnum(static_cast<unsigned char>(s[i])))
+            ++i;
+
+        if (i > begin) f(_lower(s.substr(begin, i - begin)));
+    }
+}
+
+void HelpIndex::build(const std::vector<const Argument *> &args) {
+    clear();
+
+    std::vector<std::tuple<std::string, std::uint32_t, Field>> entries;
+    for (std::uint32_t i = 0; i < args.size(); ++i) {
+        const Argument &arg = *args[i];
+        _names.emplace_back(_lower(arg.long_opt), i);
+        _split(arg.long_opt, [&](std::string word) {
+            entries.emplace_back(std::move(word), i, NAME_WORD);
+        });
+        _split(arg.help ? arg.help : "", [&](std::string word) {
+            entries.emplace_back(std::move(word), i, HELP_WORD);
+        });
+    }
+    std::sort(_names.begin(), _names.end());
+
+    // By word, then argument, best field first: only the first posting of
+    // each argument is kept
+    std::sort(entries.begin(), entries.end());
+    for (auto &[word, argument, field] : entries) {
+        if (_words.empty() || _words.back() != word) {
+            _words.emplace_back(std::move(word));
+            _first.push_back(_postings.size());
+        } else if (_postings.back().argument == argument) {
+            continue;
+        }
+        _postings.push_back({argument, field});
+    }
+    _first.push_back(_postings.size());
+    _count = args.size();
+
+    _score.assign(_count, NO_MATCH);
+    _sum.assign(_count, 0);
+    _best.assign(_count, NO_MATCH);
+}
+
+void HelpIndex::clear() {
+    _names.clear();
+    _words.clear();
+    _first.clear();
+    _postings.clear();
+    _count = 0;
+
+    _score.clear();
+    _sum.clear();
+    _best.clear();
+}
+
+std::vector<std::uint32_t> HelpIndex::search(std::string_view term) const {
+    // Rank of each argument: 2 * field, plus one for prefix matches; for
+    // more words, the sum of the best rank of each
+    std::vector<std::uint32_t> &score = _score;
+    std::vector<std::uint32_t> found;
+
+    // Names starting with the whole term (e.g. "max-s")
+    const std::string whole = _lower(term);
+    if (whole.size()) {
+        auto it = std::lower_bound(_names.begin(), _names.end(),
+                                   std::make_pair(whole, std::uint32_t{0}));
+        for (; it != _names.end() &&
+               it->first.compare(0, whole.size(), whole) == 0;
+             ++it) {
+            score[it->second] = (it->first == whole) ? 0 : 1;
+            found.push_back(it->second);
+        }
+    }
+
+    std::vector<std::string> query;
+    _split(term, [&](std::string word) { query.push_back(std::move(word)); });
+
+    // Arguments matching all the query words so far, with their sum
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> &sum = _sum;
+    std::vector<std::uint32_t> &best = _best;
+    std::vector<std::uint32_t> touched;
+
+    for (std::size_t q = 0; q < query.size(); ++q) {
+        const std::string &word = query[q];
+
+        auto it = std::lower_bound(_words.begin(), _words.end(), word);
+        for (; it != _words.end() && it->compare(0, word.size(), word) == 0;
+             ++it) {
+            const std::uint32_t w = it - _words.begin();
+            const std::uint32_t prefix = (it->size() != word.size());
+
+            for (auto p = _first[w]; p < _first[w + 1]; ++p) {
+                const Posting &posting = _postings[p];
+                std::uint32_t &b = best[posting.argument];
+                if (b == NO_MATCH) touched.push_back(posting.argument);
+                b = std::min(b, 2 * posting.field + prefix);
+            }
+        }
+
+        std::vector<std::uint32_t> next;
+        for (auto argument : (q == 0) ? touched : candidates) {
+            if (best[argument] == NO_MATCH) {
+                sum[argument] = 0;
+                continue;
+            }
+            sum[argument] += best[argument];
+            next.push_back(argument);
+        }
+        for (auto argument : touched) best[argument] = NO_MATCH;
+        touched.clear();
+        candidates = std::move(next);
+    }
+
+    for (auto argument : candidates) {
+        if (score[argument] == NO_MATCH) found.push_back(argument);
+        score[argument] = std::min(score[argument], sum[argument]);
+        sum[argument] = 0;
+    }
+
+    std::sort(found.begin(), found.end(),
+              [&](std::uint32_t lhs, std::uint32_t rhs) {
+                  return std::tie(score[lhs], lhs) < std::tie(score[rhs], rhs);
+              });
+
+    for (auto argument : found) score[argument] = NO_MATCH;
+    return found;
+}
+
+}  // namespace cmdarg
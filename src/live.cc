@@ -0,0 +1,96 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include <cmdarg/live.hpp>
+
+namespace cmdarg {
+
+// Failures are reported by reload(), the service keeps running
+static void _ignore_error(const ParseError & /*err*/) {
+}
+
+LiveOptions::LiveOptions(Parser *parser, int argc, char *const argv[])
+    : _parser(parser), _args(argv, argv + argc) {
+    for (auto &arg : _args) {
+        _argv.push_back(arg.data());
+    }
+    _argv.push_back(nullptr);
+
+    _publish(_parser->parse(argc, _argv.data()));
+}
+
+LiveOptions::~LiveOptions() noexcept {
+    // Readers are gone by now (see Reader), nothing can pin a snapshot
+    delete _current.load();
+
+    for (Slot *slot = _slots.load(); slot;) {
+        Slot *next = slot->next;
+        delete slot;
+        slot = next;
+    }
+}
+
+int LiveOptions::reload() {
+    std::lock_guard<std::mutex> guard{_reload_mutex};
+
+    int res = _parser->reloadConfig();
+    if (res) return res;
+
+    // Help requests would terminate the service, they are errors here
+    ErrorHandler handler = _parser->errorHandler();
+    bool exit_on_help = _parser->exitOnHelp();
+    _parser->setErrorHandler(_ignore_error);
+    _parser->setExitOnHelp(false);
+    Options values =
+        _parser->parse(static_cast<int>(_argv.size()) - 1, _argv.data());
+    _parser->setExitOnHelp(exit_on_help);
+    _parser->setErrorHandler(handler);
+
+    if (_parser->lastError()) return -2;
+
+    _publish(std::move(values));
+    return 0;
+}
+
+void LiveOptions::_publish(Options values) {
+    const Options *old = _current.exchange(new Options(std::move(values)));
+
+    // Readers that pinned an older epoch may still be using old; the ones
+    // reading the new epoch are guaranteed to see the new snapshot
+    const std::uint64_t epoch = _epoch.fetch_add(1) + 1;
+    for (Slot *slot = _slots.load(); slot; slot = slot->next) {
+        while (slot->epoch.load() < epoch) {
+            std::this_thread::yield();
+        }
+    }
+
+    delete old;
+}
+
+LiveOptions::Reader::Reader(LiveOptions *live) : _live(live) {
+    for (_slot = _live->_slots.load(); _slot; _slot = _slot->next) {
+        bool used = false;
+        if (_slot->used.compare_exchange_strong(used, true)) return;
+    }
+
+    _slot = new Slot;
+    _slot->next = _live->_slots.load();
+    while (!_live->_slots.compare_exchange_weak(_slot->next, _slot)) {
+    }
+}
+
+LiveOptions::Reader::~Reader() noexcept {
+    _slot->epoch.store(IDLE, std::memory_order_release);
+    _slot->used.store(false, std::memory_order_release);
+}
+
+}  // namespace cmdarg
@@ -2,17 +2,35 @@
 // Licensed by GNU GENERAL PUBLIC LICENSE v3.0
 
 // System headers
-#include <getopt.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 
 // Project headers
+#include <cmdarg/classify.hpp>
+#include <cmdarg/completion.hpp>
+#include <cmdarg/config.hpp>
+#include <cmdarg/help_index.hpp>
 #include <cmdarg/parser.hpp>
+#include <cmdarg/result_cache.hpp>
+#include <cmdarg/results_image.hpp>
+#include <cmdarg/schema.hpp>
+#include <cmdarg/session_state.hpp>
+#include <cmdarg/string_arena.hpp>
+#include <cmdarg/suggest.hpp>
+#include <cmdarg/tokenizer.hpp>
+#include <cmdarg/trie.hpp>
 
 namespace cmdarg {
 
@@ -21,25 +39,162 @@ const Argument _HELP = {
     .short_opt = 'h',
     .required = false,
     .parameter_required = Argument::ParameterRequired::NO,
-    .help = "Show this help message and exit",
+    .help = "Show this help message and exit (--help=TERM: only the options "
+            "matching TERM)",
     .action = actions::show_help_and_exit,
 };
 
-const ::option _OPTIONS_TERMINATOR = {0};
+// Key of the result holding the selected subcommand(s)
+const char _COMMAND_KEY[] = "command";
 
-bool _is_terminator(const ::option &opt) {
-    return std::memcmp(&opt, &_OPTIONS_TERMINATOR, sizeof(::option)) == 0;
-}
+// Tokens classified at once by the parse engine
+const int _CLASSIFY_WINDOW = 4096;
+
+// Owner of the destinations of parsers bound to members of different
+// structs, only its address matters
+const char _MIXED_OWNERS = 0;
+
+// Words of a command line, given either as views or as C strings; these are
+// viewed only when read, so that argv is never converted as a whole
+class Words {
+    const std::string_view *_views = nullptr;
+    char *const *_strings = nullptr;
+
+ public:
+    explicit Words(const std::string_view views[]) : _views(views) {
+    }
+    explicit Words(char *const strings[]) : _strings(strings) {
+    }
+
+    std::string_view operator[](int i) const {
+        return _views ? _views[i] : std::string_view{_strings[i]};
+    }
+
+    Words operator+(int i) const {
+        return _views ? Words{_views + i} : Words{_strings + i};
+    }
+
+    // Views of count words from i on; C strings are viewed in window,
+    // reusing its memory
+    const std::string_view *view(int i, int count,
+                                 std::vector<std::string_view> *window) const {
+        if (_views) return _views + i;
+
+        window->assign(_strings + i, _strings + i + count);
+        return window->data();
+    }
+};
+
+class ParserImpl : public ParserInterface, public ValueReader {
+    // Long names taken by arguments (and by the result key of subcommands)
+    std::unordered_set<std::string_view> _names;
 
-class ParserImpl : public ParserInterface {
-    std::map<std::string, std::string> _values;
-    std::vector<Argument> _required;
-    std::vector<Argument> _optional;
-    std::string _getopt_string;
-    std::vector<::option> _getopt_options;
+    // Owns the strings of registered arguments and subcommands
+    StringArena _strings;
+
+    // Registered arguments; after loadSchema they are filled from the schema
+    // only when needed (help, completion), hence mutable. Until then the
+    // parse builds the one argument it dispatches in _loaded_argument
+    mutable std::vector<Argument> _required;
+    mutable std::vector<Argument> _optional;
+    mutable std::vector<std::vector<const char *>> _loaded_choices;
+    mutable bool _arguments_loaded = true;
+    mutable std::optional<Argument> _loaded_argument;
+    mutable std::vector<const char *> _loaded_argument_choices;
+
+    // Compiled schema used by the parse engine, either built from the
+    // arguments above (and rebuilt whenever they change) or loaded
+    std::vector<std::uint64_t> _compiled;
+    std::vector<actions::Type> _custom_actions;
+    std::shared_ptr<const void> _mapping;
+    schema::View _schema;
+    bool _schema_valid = false;
+
+    // Kind of each token of the command line being parsed, a window at a
+    // time of tokens [_window_base, _window_end), and their views (in
+    // _window_words when they are C strings); all reused
+    classify::Table _tokens;
+    int _window_base = 0;
+    int _window_end = 0;
+    const std::string_view *_window = nullptr;
+    std::vector<std::string_view> _window_words;
+
+    // Set only during visit; scratch strings are reused for every event
+    Visitor *_visitor = nullptr;
+    int _visit_result = 0;
+    std::size_t _position = 0;
+    std::string _scratch;
+    std::string _scratch_src;
+
+    // Struct written by parseInto, set only while it visits
+    void *_base = nullptr;
+
+    // Values of the last parse and their layers, indexed like schema
+    // records; only the records in _touched may differ from their defaults.
+    // The map of results is built once, at the end of the parse, in the
+    // order of _result_order (records sorted by name, merged from the sorted
+    // optional ones of the schema and the few required ones)
+    std::vector<std::string> _record_values;
+    std::vector<Source> _sources;
+    std::vector<std::uint32_t> _touched;
+    std::vector<bool> _is_touched;
+    std::vector<std::uint32_t> _result_order;
+    bool _values_valid = false;
+
+    // Selected subcommand(s), the result under _COMMAND_KEY
+    std::string _command;
+
+    // Default providers of registered arguments, indexed like schema
+    // records, and whether each computed default was evaluated
+    enum Computed : std::uint8_t { PENDING, COMPUTING, DONE };
+    std::vector<DefaultProvider> _providers;
+    std::vector<Computed> _computed;
+
+    // Destinations of registered arguments, indexed like schema records; the
+    // struct type of all member destinations (nullptr if none,
+    // &_MIXED_OWNERS if they disagree) and the records bound to variables
+    std::vector<Destination> _destinations;
+    const void *_owner = nullptr;
+    std::vector<std::uint32_t> _bound_variables;
+
+    // Values read by loadConfig, applied under environment and command line
+    std::vector<config::Value> _config;
+    std::string _config_path;
+    std::string _config_section;
+
+    // Parsers of subcommands are set up only when selected
+    std::vector<Subcommand> _subcommands;
+    std::vector<std::unique_ptr<Parser>> _subparsers;
+    int _selected = -1;
 
     HelpFormatter _formatter;
 
+    ParseError _error;
+    ErrorHandler _error_handler = nullptr;
+    bool _exit_on_help = true;
+
+    // Results of parseCached, emptied whenever they may change; the key of
+    // each lookup is built in the same string
+    ResultCache _cache;
+    std::string _cache_key;
+
+    // Built on the first unknown option, reset by addArgument
+    SuggestionIndex _suggestions;
+    bool _suggestions_valid = false;
+
+    // Built on the first help search, reset by addArgument; values are
+    // indices in _help_arguments (_optional followed by _required)
+    mutable HelpIndex _help_index;
+    mutable std::vector<const Argument *> _help_arguments;
+    mutable bool _help_index_valid = false;
+
+    // Built on the first completion request, reset by addArgument; values
+    // are indices in _optional
+    Trie _completion_options;
+    Trie _completion_values;
+    Trie _completion_commands;
+    bool _completion_valid = false;
+
     void Init();
 
  public:
@@ -49,24 +204,109 @@ class ParserImpl : public ParserInterface {
     ~ParserImpl() noexcept override = default;
 
     // Copy construction and assignment
-    ParserImpl(const ParserImpl &rhs) = default;
-    ParserImpl &operator=(const ParserImpl &rhs) = default;
+    ParserImpl(const ParserImpl &rhs) = delete;
+    ParserImpl &operator=(const ParserImpl &rhs) = delete;
 
     // Move construction and assignment
     ParserImpl(ParserImpl &&rhs) = default;
     ParserImpl &operator=(ParserImpl &&rhs) = default;
 
     int addArgument(const Argument &opt) override;
+    int addArguments(const Argument args[], std::size_t count);
+    int addSubcommand(const Subcommand &cmd);
     Options parse(int argc, char *const argv[]) override;
+    Options parse(int argc, const std::string_view argv[]);
+    Options parse(std::string_view cmdline, Arena *arena);
     void clear() override;
     std::string getHelp() const override;
 
+    std::vector<std::string> complete(int argc, char *const argv[]);
+
+    const ParseError &lastError() const;
+    void setErrorHandler(ErrorHandler handler);
+    ErrorHandler errorHandler() const;
+
+    int saveSchema(std::ostream *os);
+    int loadSchema(const void *data, std::size_t size);
+    int mapSchema(const std::string &path);
+
+    int loadConfig(const std::string &path, const std::string &section);
+    int reloadConfig();
+    Source source(const std::string &name) const;
+
+    std::uint64_t schemaHash();
+    int saveResults(const Options &values, std::string *out);
+
+    int visit(int argc, char *const argv[], Visitor *visitor);
+    int visit(int argc, const std::string_view argv[], Visitor *visitor);
+    std::uint32_t argumentId(std::string_view name);
+
+    int value(const std::string &name, std::string *out) override;
+
+    Options parseNamespace(int argc, const std::string_view argv[],
+                           std::string_view name_space);
+
+    std::string searchHelp(const std::string &term) const;
+
+    int bindDefaults(void *base, const void *owner);
+    int parseInto(int argc, char *const argv[], void *base, const void *owner);
+    int parseInto(int argc, const std::string_view argv[], void *base,
+                  const void *owner);
+
+    std::shared_ptr<const Options> parseCached(int argc, char *const argv[]);
+    std::shared_ptr<const Options> parseCached(
+        int argc, const std::string_view argv[]);
+    void setCacheCapacity(std::size_t bytes);
+    CacheStats cacheStats() const;
+
+    int validate(session::State *state);
+
+    void setExitOnHelp(bool exit);
+    bool exitOnHelp() const;
+
  private:
-    inline ::option _construct_option(const Argument &arg_options);
-    inline std::string _construct_string(const Argument &arg_options);
+    int _check(const Argument &arg_options) const;
+    void _register(const Argument &arg_options);
+
+    void _compile();
+    void _load_arguments() const;
+    const Argument &_argument(std::uint32_t index) const;
+
+    void _reset_values();
+    std::string *_modify(std::uint32_t index);
+    Options _results() const;
+
+    Options _parse_words(int argc, Words argv);
+    std::shared_ptr<const Options> _parse_cached(int argc, Words argv);
+    int _visit_words(int argc, Words argv, Visitor *visitor);
+    int _parse_into(int argc, Words argv, void *base, const void *owner);
 
-    int _parse_and_update_value(const Argument &arg_options,
-                                const std::string &src);
+    Options _parse_tokens(std::string_view prog, int count, Words tokens);
+    std::string_view _token(Words tokens, int i) const;
+    int _parse_long(int count, Words tokens, int *i);
+    int _parse_short(int count, Words tokens, int *i);
+    int _dispatch(std::uint32_t index, std::string_view value,
+                  Source source = Source::COMMAND_LINE);
+
+    int _apply_layers();
+    int _apply_value(std::uint32_t index, const char *value, Source source);
+
+    int _run_action(const Argument &arg_options, const std::string &src,
+                    std::string *dest);
+    int _update(std::uint32_t index, std::string_view value);
+    int _visit(std::uint32_t index, std::string_view value);
+    int _store(std::uint32_t index, std::string_view value);
+
+    void _suggest_option(std::string_view name);
+    void _search_help(std::ostream *os, std::string_view term) const;
+    Options _fail(std::string_view prog);
+
+    Parser *_subparser(int index);
+    std::string _subsection(const char *name) const;
+    Options _parse_subcommand(std::string_view prog, int argc, Words argv);
+
+    void _build_completion();
+    bool _handle_completion_request(int argc, char *const argv[]);
 };
 
 void ParserImpl::Init() {
@@ -81,200 +321,1715 @@ ParserImpl::ParserImpl(const HelpFormatter &fmt) : _formatter(fmt) {
     Init();
 }
 
+int ParserImpl::_check(const Argument &arg_options) const {
+    if (arg_options.long_opt == nullptr ||
+        std::strlen(arg_options.long_opt) < 2 ||
+        std::strlen(arg_options.long_opt) > schema::MAX_NAME_LENGTH) {
+        // Invalid argument
+        return -1;
+    }
+
+    if (arg_options.required && _subcommands.size()) {
+        // Positional arguments are taken by subcommands
+        return -3;
+    }
+
+    if (arg_options.required && arg_options.env) {
+        // Positional arguments come from the command line only
+        return -1;
+    }
+
+    return 0;
+}
+
+void ParserImpl::_register(const Argument &arg_options) {
+    const Argument arg = {
+        .long_opt = _strings.intern(arg_options.long_opt),
+        .short_opt = arg_options.short_opt,
+        .required = arg_options.required,
+        .parameter_required = arg_options.parameter_required,
+        .help = _strings.intern(arg_options.help),
+        .default_value = _strings.intern(arg_options.default_value),
+        .action = arg_options.action,
+        .choices = _strings.internList(arg_options.choices),
+        .env = _strings.intern(arg_options.env),
+        .default_provider = arg_options.default_provider,
+        .destination = arg_options.destination,
+    };
+
+    if (arg.required) {
+        _required.emplace_back(arg);
+    } else {
+        _optional.emplace_back(arg);
+    }
+    _names.insert(arg.long_opt);
+
+    _schema_valid = false;
+    _suggestions_valid = false;
+    _help_index_valid = false;
+    _completion_valid = false;
+    _cache.clear();
+}
+
 // TODO(gabara): error codes
 int ParserImpl::addArgument(const Argument &arg_options) {
-    if (arg_options.long_opt == nullptr ||
-        std::strlen(arg_options.long_opt) < 2) {
+    if (arg_options.long_opt == nullptr) {
         // Invalid argument
         return -1;
     }
 
-    std::string optname = arg_options.long_opt;
-    if (_values.find(optname) != _values.end()) {
+    if (!_arguments_loaded) {
+        // Extending a loaded schema, go back to registered arguments
+        _load_arguments();
+        clear();
+    }
+
+    if (_names.count(arg_options.long_opt)) {
         // String already taken
         return -2;
     }
-    _values[arg_options.long_opt] = "";
 
-    if (arg_options.required) {
-        _required.emplace_back(arg_options);
-    } else {
-        _optional.emplace_back(arg_options);
+    int res = _check(arg_options);
+    if (res) return res;
 
-        ::option opt = _construct_option(arg_options);
-        if (_getopt_options.size() && _is_terminator(_getopt_options.back())) {
-            // Overwrite terminator, will be re-inserted upon parsing
-            _getopt_options.back() = opt;
-        } else {
-            _getopt_options.emplace_back(opt);
+    _register(arg_options);
+    return 0;
+}
+
+int ParserImpl::addArguments(const Argument args[], std::size_t count) {
+    if (!_arguments_loaded) {
+        _load_arguments();
+        clear();
+    }
+
+    // New names, checked in a single pass before registering anything
+    std::unordered_set<std::string_view> names;
+    names.reserve(2 * count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        int res = _check(args[i]);
+        if (res) return res;
+
+        if (_names.count(args[i].long_opt) ||
+            !names.insert(args[i].long_opt).second) {
+            // String already taken
+            return -2;
         }
+    }
 
-        _getopt_string += _construct_string(arg_options);
+    for (std::size_t i = 0; i < count; ++i) {
+        _register(args[i]);
     }
 
+    // Compiles the schema and fills the values once for all of them
+    clear();
     return 0;
 }
 
-// int parse_optional(int *last, int argc, char *const argv[],
-//                    ::option *getopt_options, const char *getopt_string) {
-// }
+int ParserImpl::addSubcommand(const Subcommand &cmd) {
+    if (cmd.name == nullptr || std::strlen(cmd.name) < 1 ||
+        cmd.name[0] == '-' || cmd.setup == nullptr) {
+        // Invalid subcommand
+        return -1;
+    }
+
+    for (const auto &other : _subcommands) {
+        if (std::strcmp(other.name, cmd.name) == 0) {
+            // Name already taken
+            return -2;
+        }
+    }
+
+    _load_arguments();
+    if (_required.size()) {
+        // Positional arguments are taken by subcommands
+        return -3;
+    }
+
+    if (_subcommands.empty()) {
+        if (_names.count(_COMMAND_KEY)) {
+            // Result key already taken by an argument
+            return -2;
+        }
+        _names.insert(_COMMAND_KEY);
+    }
+
+    _subcommands.push_back({
+        .name = _strings.intern(cmd.name),
+        .help = _strings.intern(cmd.help),
+        .setup = cmd.setup,
+    });
+    _subparsers.emplace_back(nullptr);
+    _completion_valid = false;
+    _cache.clear();
+    return 0;
+}
 
 Options ParserImpl::parse(int argc, char *const argv[]) {
-    if (_getopt_options.empty()) return _values;
+    if (_handle_completion_request(argc, argv)) {
+        std::exit(EXIT_SUCCESS);
+    }
+
+    return _parse_words(argc, Words{argv});
+}
+
+Options ParserImpl::parse(int argc, const std::string_view argv[]) {
+    return _parse_words(argc, Words{argv});
+}
+
+Options ParserImpl::_parse_words(int argc, Words argv) {
+    // No words at all (not even the program name) is an empty command line
+    const std::string_view prog = argc ? argv[0] : std::string_view{};
+    return _parse_tokens(prog, std::max(argc - 1, 0), argv + (argc > 0));
+}
+
+Options ParserImpl::parse(std::string_view cmdline, Arena *arena) {
+    const std::string_view *words;
+    std::size_t count;
+
+    const int res = tokenizer::split(cmdline, arena, &words, &count);
+    if (res) {
+        clear();
+        _error = ParseError{};
+        _error.kind = (res == -2) ? ParseError::Kind::ARENA_EXHAUSTED
+                                  : ParseError::Kind::INVALID_COMMAND_LINE;
+        _error.token = cmdline;
+        return _fail(_formatter.params().prog);
+    }
+
+    // There is no program name, the first word is already an argument
+    return _parse_tokens(_formatter.params().prog, count, Words{words});
+}
+
+// Appends a length-prefixed word to a cache key, so that no two different
+// sequences of words give the same key
+static void _append_word(std::string *key, const char *data,
+                         std::uint32_t length) {
+    key->append(reinterpret_cast<const char *>(&length), sizeof(length));
+    if (data) key->append(data, length);
+}
+
+std::shared_ptr<const Options> ParserImpl::parseCached(int argc,
+                                                       char *const argv[]) {
+    if (_handle_completion_request(argc, argv)) {
+        std::exit(EXIT_SUCCESS);
+    }
+
+    return _parse_cached(argc, Words{argv});
+}
+
+std::shared_ptr<const Options> ParserImpl::parseCached(
+    int argc, const std::string_view argv[]) {
+    return _parse_cached(argc, Words{argv});
+}
+
+std::shared_ptr<const Options> ParserImpl::_parse_cached(int argc,
+                                                         Words argv) {
+    if (_cache.capacity() == 0) {
+        return std::make_shared<const Options>(_parse_words(argc, argv));
+    }
+
+    if (!_schema_valid) _compile();
+
+    // The program name does not change results, the environment does
+    _cache_key.clear();
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view word = argv[i];
+        _append_word(&_cache_key, word.data(), word.size());
+    }
+    for (std::uint32_t i = 0; i < _schema.optionalCount(); ++i) {
+        if (!(_schema.record(i).flags & schema::FLAG_ENV)) continue;
+
+        const char *value = std::getenv(_schema.env(i));
+        if (value) {
+            _append_word(&_cache_key, value, std::strlen(value));
+        } else {
+            _append_word(&_cache_key, nullptr, ~0U);
+        }
+    }
+
+    const std::uint64_t hash = ResultCache::hash(_cache_key);
+    ResultCache::Result result = _cache.find(_cache_key, hash);
+    if (result) {
+        _error = ParseError{};
+        return result;
+    }
+
+    const std::string_view prog = argc ? argv[0] : std::string_view{};
+    result = std::make_shared<const Options>(
+        _parse_tokens(prog, std::max(argc - 1, 0), argv + (argc > 0)));
+    if (!_error) _cache.insert(_cache_key, hash, result);
+    return result;
+}
+
+void ParserImpl::setCacheCapacity(std::size_t bytes) {
+    _cache.setCapacity(bytes);
+}
+
+CacheStats ParserImpl::cacheStats() const {
+    return _cache.stats();
+}
+
+Options ParserImpl::parseNamespace(int argc, const std::string_view argv[],
+                                   std::string_view name_space) {
+    if (!_schema_valid) _compile();
+
+    const std::string prefix =
+        name_space.empty() ? "" : std::string(name_space) + ".";
+
+    // Only a few of the words are ours, the others are not even looked up
+    std::vector<std::string_view> tokens;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view token = argv[i];
+        if (token == "--") break;
+        if (token.size() < 3 || token.substr(0, 2) != "--") continue;
+
+        const std::string_view name =
+            token.substr(2, token.find('=') - 2);
+        if (name.substr(0, prefix.size()) != prefix) continue;
+
+        // Help belongs to the program
+        if (name == _HELP.long_opt) continue;
+
+        // Without a namespace, exact names only: prefixes may belong to the
+        // program. Within one, abbreviations of ours are taken like the
+        // full names (ambiguous ones are reported by the parse below)
+        std::uint32_t index = _schema.findLong(name);
+        if (index == schema::NONE && prefix.empty()) continue;
+        if (index == schema::NONE) {
+            std::uint32_t first;
+            std::uint32_t last;
+            _schema.findPrefix(name, &first, &last);
+            if (last - first == 1) index = _schema.sortedAt(first);
+        }
+
+        tokens.emplace_back(token);
+
+        // Unknown ones are reported by the parse below
+        if (index != schema::NONE &&
+            _schema.parameter(_schema.record(index)) ==
+                Argument::ParameterRequired::REQUIRED &&
+            name.size() + 2 == token.size() && i + 1 < argc) {
+            tokens.emplace_back(argv[++i]);
+        }
+    }
+
+    return _parse_tokens(argc ? argv[0] : std::string_view{},
+                         tokens.size(), Words{tokens.data()});
+}
+
+int ParserImpl::visit(int argc, char *const argv[], Visitor *visitor) {
+    return _visit_words(argc, Words{argv}, visitor);
+}
+
+int ParserImpl::visit(int argc, const std::string_view argv[],
+                      Visitor *visitor) {
+    return _visit_words(argc, Words{argv}, visitor);
+}
+
+int ParserImpl::_visit_words(int argc, Words argv, Visitor *visitor) {
+    if (_subcommands.size()) return -2;
+
+    if (!_schema_valid) _compile();
+
+    _visitor = visitor;
+    _visit_result = 0;
+    // No words at all (not even the program name) is an empty command line
+    const std::string_view prog = argc ? argv[0] : std::string_view{};
+    _parse_tokens(prog, std::max(argc - 1, 0), argv + (argc > 0));
+    _visitor = nullptr;
+
+    if (_visit_result) return _visit_result;
+    return _error ? -1 : 0;
+}
+
+int ParserImpl::bindDefaults(void *base, const void *owner) {
+    if (!_schema_valid) _compile();
+    if (_owner != nullptr && _owner != owner) return -3;
 
-    // Force the last element to be all zeroes
-    if (!_is_terminator(_getopt_options.back()))
-        _getopt_options.emplace_back(_OPTIONS_TERMINATOR);
+    for (std::uint32_t i = 0; i < _destinations.size(); ++i) {
+        const Destination &d = _destinations[i];
+        if (d.store == nullptr || d.variable != nullptr) continue;
 
+        // Empty defaults leave the initializers of the struct alone
+        const std::string_view value = _schema.defaultValue(i);
+        if (value.size() && d.store(base, value)) return -4;
+    }
+
+    return 0;
+}
+
+int ParserImpl::parseInto(int argc, char *const argv[], void *base,
+                          const void *owner) {
+    return _parse_into(argc, Words{argv}, base, owner);
+}
+
+int ParserImpl::parseInto(int argc, const std::string_view argv[],
+                          void *base, const void *owner) {
+    return _parse_into(argc, Words{argv}, base, owner);
+}
+
+int ParserImpl::_parse_into(int argc, Words argv, void *base,
+                            const void *owner) {
+    if (_subcommands.size()) return -2;
+    if (!_schema_valid) _compile();
+    if (_owner != nullptr && _owner != owner) return -3;
+
+    for (std::uint32_t index : _bound_variables) {
+        const Destination &d = _destinations[index];
+        const std::string_view value = _schema.defaultValue(index);
+        if (value.size() && d.store(d.variable, value)) return -4;
+    }
+
+    // Values go to their destinations only, the visitor gets nothing
+    Visitor ignore;
+    _base = base;
+    int res = _visit_words(argc, argv, &ignore);
+    _base = nullptr;
+    return res;
+}
+
+std::uint32_t ParserImpl::argumentId(std::string_view name) {
+    if (!_schema_valid) _compile();
+
+    std::uint32_t index = _schema.findLong(name);
+    if (index != schema::NONE) return index;
+
+    // Required arguments are not in the lookup tables, there are few
+    const std::uint32_t n_optional = _schema.optionalCount();
+    for (std::uint32_t i = 0; i < _schema.requiredCount(); ++i) {
+        if (_schema.longOpt(_schema.record(n_optional + i)) == name)
+            return n_optional + i;
+    }
+    return NO_ARGUMENT;
+}
+
+Options ParserImpl::_parse_tokens(std::string_view prog, int count,
+                                  Words tokens) {
     // Clear all default values
     clear();
+    _error = ParseError{};
+
+    // Visits report the command line only
+    if (_visitor == nullptr && _apply_layers()) {
+        return _fail(prog);
+    }
 
     // TODO(gabara): help is parsed alongside all the other variables.
     // This can lead to some issues when previous values show an error.
 
-    optind = 1;
+    // Options and positional arguments may be mixed (as GNU getopt does by
+    // permuting argv), positional ones are assigned in order as they come
+    const std::uint32_t n_optional = _schema.optionalCount();
+    const std::uint32_t n_required = _schema.requiredCount();
+    std::uint32_t req_option = 0;
+    bool options_done = false;
 
-    // Parse optional arguments first
-    while (true) {
-        int option_index = -1;
+    _window_base = 0;
+    _window_end = 0;
 
-        int c = getopt_long(argc, argv, _getopt_string.c_str(),
-                            _getopt_options.data(), &option_index);
-        if (c == -1) {
-            break;
+    for (int i = 0; i < count; ++i) {
+        if (i >= _window_end) {
+            // Viewing and classifying a window at a time keeps memory
+            // bounded however long the command line is
+            const int n = std::min(count - i, _CLASSIFY_WINDOW);
+            _window = tokens.view(i, n, &_window_words);
+            classify::build(n, _window, &_tokens);
+            _window_base = i;
+            _window_end = i + n;
         }
 
-        if (c == '?') {
-            std::cerr << std::endl;
-            _formatter.formatHelp(&std::cerr, _required, _optional);
-            std::exit(EXIT_FAILURE);
-        }
+        const std::string_view token = _window[i - _window_base];
+        const std::uint8_t kind = _tokens.kinds[i - _window_base];
+        _position = i + 1;
+        int res = 0;
 
-        if (option_index < 0) {
-            // Happens when a short option is supplied,
-            // track the corresponding long option index
-            for (option_index = 0; option_index < _getopt_options.size();
-                 ++option_index) {
-                if (_getopt_options[option_index].val == c) break;
+        if (options_done || kind == classify::POSITIONAL) {
+            if (_subcommands.size()) {
+                // Everything from here on belongs to the subcommand
+                return _parse_subcommand(prog, count - i, tokens + i);
             }
-            // assert(option_index != _getopt_options.size());
-        }
-
-        const char *arg_options = optarg;
-        if (!arg_options) arg_options = "";
 
-        int res = _parse_and_update_value(_optional[option_index], arg_options);
-        if (res) {
-            std::ostream *outs = &std::cerr;
-            int exit_code = EXIT_FAILURE;
-            if (_values["help"] == "true") {
-                outs = &std::cout;
-                exit_code = EXIT_SUCCESS;
+            if (req_option < n_required) {
+                res = _dispatch(n_optional + req_option++, token);
+            } else if (_visitor && _base == nullptr) {
+                res = _visit(NO_ARGUMENT, token);
+            } else if (_error.kind == ParseError::Kind::NONE) {
+                _error.kind = ParseError::Kind::TOO_MANY_ARGUMENTS;
+                _error.token = token;
             } else {
-                *outs << std::endl;
+                _error.token += ' ';
+                _error.token += token;
             }
+        } else if (kind == classify::END_OF_OPTIONS) {
+            options_done = true;
+        } else if (kind == classify::LONG) {
+            res = _parse_long(count, tokens, &i);
+        } else {
+            res = _parse_short(count, tokens, &i);
+        }
 
-            _formatter.formatHelp(outs, _required, _optional);
-            std::exit(exit_code);
+        if (res > 0) {
+            // Stopped by the visitor, not an error
+            if (_visit_result) return {};
+            return _fail(prog);
         }
     }
 
-    // Parse required options after optional ones
-    int req_option = 0;
-    while (optind < argc && req_option < _required.size()) {
-        _parse_and_update_value(_required[req_option++], argv[optind++]);
+    if (_error) {
+        return _fail(prog);
     }
 
-    if (optind < argc) {
-        std::cerr << argv[0] << ": too many required options:";
-        for (; optind < argc; ++optind) {
-            std::cerr << " " << argv[optind];
-        }
-        std::cerr << std::endl;
+    if (_subcommands.size()) {
+        _error.kind = ParseError::Kind::MISSING_ARGUMENTS;
+        _error.token = "COMMAND";
+        return _fail(prog);
+    }
 
-        _formatter.formatHelp(&std::cerr, _required, _optional);
-        std::exit(EXIT_FAILURE);
+    if (req_option < n_required) {
+        _load_arguments();
+        _error.kind = ParseError::Kind::MISSING_ARGUMENTS;
+        _error.token = _formatter.metavar(_required[req_option]);
+        while (++req_option < n_required) {
+            _error.token += " " + _formatter.metavar(_required[req_option]);
+        }
+        return _fail(prog);
     }
 
-    if (req_option < _required.size()) {
-        std::cerr << argv[0] << ": missing required options:";
+    return _results();
+}
+
+// Parameters may be the first word after the window
+std::string_view ParserImpl::_token(Words tokens, int i) const {
+    if (i < _window_end) return _window[i - _window_base];
+    return tokens[i];
+}
+
+int ParserImpl::_parse_long(int count, Words tokens, int *i) {
+    const std::string_view token = _token(tokens, *i);
+    const std::uint32_t equal = _tokens.equals[*i - _window_base];
+    const std::string_view name = token.substr(
+        2, (equal == classify::NONE) ? std::string_view::npos : equal - 2);
+
+    std::uint32_t index = _schema.findLong(name);
+    if (index == schema::NONE) {
+        // Unambiguous prefixes are accepted, as GNU getopt does
+        std::uint32_t first;
+        std::uint32_t last;
+        _schema.findPrefix(name, &first, &last);
 
-        for (; req_option < _required.size(); ++req_option) {
-            std::cerr << " " << _formatter.metavar(_required[req_option]);
+        if (last - first == 1) {
+            index = _schema.sortedAt(first);
+        } else if (last - first > 1) {
+            _error.kind = ParseError::Kind::AMBIGUOUS_OPTION;
+            _error.token = "--" + std::string(name);
+            for (; first < last; ++first) {
+                const auto &r = _schema.record(_schema.sortedAt(first));
+                _error.suggestions.emplace_back(
+                    "--" + std::string(_schema.longOpt(r)));
+            }
+            return 1;
+        } else {
+            _error.kind = ParseError::Kind::UNKNOWN_OPTION;
+            _error.token = "--" + std::string(name);
+            _suggest_option(name);
+            return 1;
         }
-        std::cerr << std::endl;
+    }
 
-        _formatter.formatHelp(&std::cerr, _required, _optional);
-        std::exit(EXIT_FAILURE);
+    const schema::Record &r = _schema.record(index);
+    const bool has_value = equal != classify::NONE;
+    std::string_view value;
+
+    switch (_schema.parameter(r)) {
+        case Argument::ParameterRequired::NO:
+            if (has_value && r.action == actions::predefinedId(
+                                             actions::show_help_and_exit)) {
+                // --help=TERM searches the help
+                value = token.substr(equal + 1);
+            } else if (has_value) {
+                _error.kind = ParseError::Kind::UNEXPECTED_PARAMETER;
+                _error.token = "--" + std::string(_schema.longOpt(r));
+                return 1;
+            }
+            break;
+        case Argument::ParameterRequired::REQUIRED:
+            if (has_value) {
+                value = token.substr(equal + 1);
+            } else if (*i + 1 < count) {
+                value = _token(tokens, ++*i);
+            } else {
+                _error.kind = ParseError::Kind::MISSING_PARAMETER;
+                _error.token = "--" + std::string(_schema.longOpt(r));
+                return 1;
+            }
+            break;
+        case Argument::ParameterRequired::OPTIONAL:
+            if (has_value) value = token.substr(equal + 1);
+            break;
     }
 
-    return _values;
+    return _dispatch(index, value);
 }
 
-void ParserImpl::clear() {
-    for (const auto arg : _required) {
-        _values[arg.long_opt] = arg.default_value;
-    }
-    for (const auto arg : _optional) {
-        _values[arg.long_opt] = arg.default_value;
+int ParserImpl::_parse_short(int count, Words tokens, int *i) {
+    const std::string_view token = _token(tokens, *i);
+
+    // Cluster of short options, the first one accepting a parameter takes
+    // the rest of the token (or the next one, if required)
+    for (std::size_t c = 1; c < token.size(); ++c) {
+        std::uint32_t index = _schema.findShort(token[c]);
+        if (index == schema::NONE) {
+            _error.kind = ParseError::Kind::UNKNOWN_OPTION;
+            _error.token = std::string("-") + token[c];
+            return 1;
+        }
+
+        const schema::Record &r = _schema.record(index);
+        const std::string_view rest = token.substr(c + 1);
+        std::string_view value;
+
+        switch (_schema.parameter(r)) {
+            case Argument::ParameterRequired::NO: {
+                int res = _dispatch(index, value);
+                if (res) return res;
+                continue;
+            }
+            case Argument::ParameterRequired::REQUIRED:
+                if (rest.size()) {
+                    value = rest;
+                } else if (*i + 1 < count) {
+                    value = _token(tokens, ++*i);
+                } else {
+                    _error.kind = ParseError::Kind::MISSING_PARAMETER;
+                    _error.token = std::string("-") + token[c];
+                    return 1;
+                }
+                break;
+            case Argument::ParameterRequired::OPTIONAL:
+                value = rest;
+                break;
+        }
+
+        return _dispatch(index, value);
     }
-}
 
-std::string ParserImpl::getHelp() const {
-    std::ostringstream oss;
-    _formatter.formatHelp(&oss, _required, _optional);
-    return oss.str();
+    return 0;
 }
 
-::option ParserImpl::_construct_option(const Argument &arg_options) {
-    // NOTE: arg_options.parameter_required has the same representation as
-    // has_arg on purpose
-    ::option the_option = {
-        .name = arg_options.long_opt,
-        .has_arg = static_cast<int>(arg_options.parameter_required),
-        .flag = 0,
-        .val = arg_options.short_opt,
-    };
-    return the_option;
+int ParserImpl::_update(std::uint32_t index, std::string_view value) {
+    const Argument &arg = _argument(index);
+
+    // The action works on a copy, kept only if the value is valid; scratch
+    // strings keep their memory across updates
+    std::string *dest = _modify(index);
+    _scratch = *dest;
+    _scratch_src = value;
+    int res = _run_action(arg, _scratch_src, &_scratch);
+    if (res > 0) return res;
+
+    dest->swap(_scratch);
+    return res;
 }
 
-std::string ParserImpl::_construct_string(const Argument &arg_options) {
-    std::string out;
+int ParserImpl::_visit(std::uint32_t index, std::string_view value) {
+    Event event = {
+        .id = index,
+        .name = {},
+        .value = value,
+        .converted = value,
+        .position = _position,
+    };
 
-    if (arg_options.short_opt) {
-        out += arg_options.short_opt;
+    if (index == NO_ARGUMENT) {
+        int res = _visitor->onPositional(event);
+        if (res) _visit_result = res;
+        return res ? 1 : 0;
     }
 
-    // Using property of GNU getopt, optional arguments are marked with a value
-    // of 2 and exactly 2 ':' characters must be supplied
-    for (int i = 0; i < static_cast<int>(arg_options.parameter_required); ++i) {
-        out += ':';
+    const Argument &arg = _argument(index);
+
+    // Occurrences add to the value so far, as in parse (e.g. increments);
+    // scratch strings keep their memory across events
+    std::string *current = _modify(index);
+    _scratch = *current;
+    _scratch_src = value;
+    int res = _run_action(arg, _scratch_src, &_scratch);
+    if (res) return res;
+    current->swap(_scratch);
+
+    if (_base) {
+        res = _store(index, *current);
+        if (res) return res;
     }
 
-    return out;
+    event.name = arg.long_opt;
+    event.converted = *current;
+    res = (index < _schema.optionalCount()) ? _visitor->onOption(event)
+                                            : _visitor->onPositional(event);
+    if (res) _visit_result = res;
+    return res ? 1 : 0;
 }
 
-int ParserImpl::_parse_and_update_value(const Argument &arg_options,
-                                        const std::string &src) {
-    // Get stored value
-    std::string dest = _values[arg_options.long_opt];
+int ParserImpl::_store(std::uint32_t index, std::string_view value) {
+    // Loaded schemas have no destinations
+    if (index >= _destinations.size()) return 0;
 
-    // Request action call
-    int res = arg_options.action(&dest, arg_options, src);
-    if (res > 0) return res;
+    const Destination &d = _destinations[index];
+    if (d.store == nullptr) return 0;
+    if (d.store(d.variable ? d.variable : _base, value) == 0) return 0;
+
+    // Checked by the action, but too large for the field (or not a number)
+    _error.kind = ParseError::Kind::INVALID_VALUE;
+    _error.token = _scratch_src;
+    return 1;
+}
+
+int ParserImpl::_dispatch(std::uint32_t index, std::string_view value,
+                          Source source) {
+    int res;
+
+    if (_visitor && source == Source::COMMAND_LINE) {
+        res = _visit(index, value);
+    } else {
+        if (_sources[index] != source) {
+            // Higher layers replace values instead of adding to them (e.g.
+            // for increment actions)
+            _modify(index)->assign(_schema.defaultValue(index));
+            _sources[index] = source;
+        }
+        res = _update(index, value);
+    }
 
-    // Update stored value
-    _values[arg_options.long_opt] = dest;
+    if (res < 0) {
+        // Only an explicit request shows the help
+        if (source != Source::COMMAND_LINE) return 0;
+
+        if (!_exit_on_help) {
+            _error.kind = ParseError::Kind::HELP_REQUESTED;
+            _error.token = value;
+            return 1;
+        }
+
+        _load_arguments();
+        if (value.size()) {
+            _search_help(&std::cout, value);
+        } else {
+            _formatter.formatHelp(&std::cout, _required, _optional,
+                                  _subcommands);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
 
     return res;
 }
 
-Parser::Parser(const HelpFormatter::Params &p) {
-    _impl = std::make_unique<ParserImpl>(p);
+int ParserImpl::_apply_layers() {
+    for (const auto &[name, value] : _config) {
+        std::uint32_t index = _schema.findLong(name);
+        if (index == schema::NONE) continue;
+
+        int res = _apply_value(index, value.c_str(), Source::CONFIG_FILE);
+        if (res) return res;
+    }
+
+    for (std::uint32_t i = 0; i < _schema.optionalCount(); ++i) {
+        if (!(_schema.record(i).flags & schema::FLAG_ENV)) continue;
+
+        const char *value = std::getenv(_schema.env(i));
+        if (value == nullptr) continue;
+
+        int res = _apply_value(i, value, Source::ENVIRONMENT);
+        if (res) return res;
+    }
+
+    return 0;
+}
+
+int ParserImpl::_apply_value(std::uint32_t index, const char *value,
+                             Source source) {
+    const schema::Record &r = _schema.record(index);
+    if (_schema.parameter(r) != Argument::ParameterRequired::NO) {
+        return _dispatch(index, value, source);
+    }
+
+    // Arguments without parameters are switched on or off
+    bool on;
+    if (!config::parseBool(value, &on)) {
+        std::cerr << "Error: argument ";
+        if (r.short_opt) {
+            std::cerr << r.short_opt << "/";
+        }
+        std::cerr << _schema.longOpt(r) << ": invalid boolean value: '"
+                  << value << "'" << std::endl;
+        _error.kind = ParseError::Kind::INVALID_VALUE;
+        _error.token = value;
+        return 1;
+    }
+
+    if (on) {
+        return _dispatch(index, "", source);
+    }
+
+    _modify(index)->assign(_schema.defaultValue(index));
+    _sources[index] = source;
+    return 0;
+}
+
+Options ParserImpl::_parse_subcommand(std::string_view prog, int argc,
+                                      Words argv) {
+    int index = 0;
+    for (; index < static_cast<int>(_subcommands.size()); ++index) {
+        if (_subcommands[index].name == argv[0]) break;
+    }
+
+    if (index == static_cast<int>(_subcommands.size())) {
+        _error.kind = ParseError::Kind::UNKNOWN_COMMAND;
+        _error.token = argv[0];
+
+        SuggestionIndex names;
+        for (const auto &cmd : _subcommands) {
+            names.add(cmd.name);
+        }
+        _error.suggestions = names.suggest(argv[0]);
+
+        // Reported by this parser, argv[0] is the unknown word
+        return _fail(prog);
+    }
+
+    // The subcommand sees its own name as argv[0]
+    _selected = index;
+    Parser *sub = _subparser(index);
+    Options sub_values = sub->_impl->_parse_words(argc, argv);
+    if (sub->lastError()) {
+        _error = sub->lastError();
+        return _results();
+    }
+
+    // Values of the subcommand are merged with ours, names must not clash
+    // (but for --help); "command" is ours unless it holds nested ones
+    if (sub->argumentId(_COMMAND_KEY) != NO_ARGUMENT) {
+        _error.kind = ParseError::Kind::NAME_CONFLICT;
+        _error.token = std::string("--") + _COMMAND_KEY;
+        return _fail(prog);
+    }
+
+    _command = _subcommands[index].name;
+    if (sub_values.count(_COMMAND_KEY)) {
+        _command += " " + sub_values[_COMMAND_KEY];
+    }
+
+    Options out = _results();
+    for (auto &[key, value] : sub_values) {
+        if (key == _HELP.long_opt || key == _COMMAND_KEY) continue;
+        if (!out.try_emplace(key, std::move(value)).second) {
+            _command.clear();
+            _error.kind = ParseError::Kind::NAME_CONFLICT;
+            _error.token = "--" + key;
+            return _fail(prog);
+        }
+    }
+    out[_COMMAND_KEY] = _command;
+    return out;
+}
+
+Parser *ParserImpl::_subparser(int index) {
+    if (!_subparsers[index]) {
+        const Subcommand &cmd = _subcommands[index];
+
+        HelpFormatter::Params params = _formatter.params();
+        params.prog += std::string(" ") + cmd.name;
+        params.description = cmd.help;
+        params.epilogue = "";
+
+        // Settings of this parser first, setup may change them
+        _subparsers[index] = std::make_unique<Parser>(params);
+        _subparsers[index]->setErrorHandler(_error_handler);
+        _subparsers[index]->setExitOnHelp(_exit_on_help);
+        cmd.setup(_subparsers[index].get());
+
+        if (_config_path.size()) {
+            _subparsers[index]->loadConfig(_config_path,
+                                           _subsection(cmd.name));
+        }
+    }
+
+    return _subparsers[index].get();
+}
+
+void ParserImpl::clear() {
+    if (!_schema_valid) _compile();
+
+    _command.clear();
+    _selected = -1;
+
+    if (!_values_valid) {
+        _reset_values();
+        return;
+    }
+
+    // Only the values set by the last parse are restored
+    for (std::uint32_t index : _touched) {
+        _record_values[index].assign(_schema.defaultValue(index));
+        _sources[index] = Source::DEFAULT;
+        _computed[index] = PENDING;
+        _is_touched[index] = false;
+    }
+    _touched.clear();
+}
+
+void ParserImpl::_reset_values() {
+    const std::uint32_t n =
+        _schema.optionalCount() + _schema.requiredCount();
+
+    _record_values.resize(n);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        _record_values[i].assign(_schema.defaultValue(i));
+    }
+    _sources.assign(n, Source::DEFAULT);
+    _computed.assign(n, PENDING);
+    _touched.clear();
+    _is_touched.assign(n, false);
+
+    // Optional records come sorted in the schema, only the required ones
+    // are sorted here and merged with them
+    const std::uint32_t n_optional = _schema.optionalCount();
+    auto by_name = [this](std::uint32_t a, std::uint32_t b) {
+        return _schema.longOpt(_schema.record(a)) <
+               _schema.longOpt(_schema.record(b));
+    };
+    _result_order.resize(n);
+    for (std::uint32_t i = 0; i < n_optional; ++i) {
+        _result_order[i] = _schema.sortedAt(i);
+    }
+    for (std::uint32_t i = n_optional; i < n; ++i) _result_order[i] = i;
+    std::sort(_result_order.begin() + n_optional, _result_order.end(),
+              by_name);
+    std::inplace_merge(_result_order.begin(),
+                       _result_order.begin() + n_optional,
+                       _result_order.end(), by_name);
+
+    _values_valid = true;
+}
+
+// Value of record index, about to be changed: restored by the next clear
+std::string *ParserImpl::_modify(std::uint32_t index) {
+    if (!_is_touched[index]) {
+        _is_touched[index] = true;
+        _touched.emplace_back(index);
+    }
+    return &_record_values[index];
+}
+
+Options ParserImpl::_results() const {
+    // Visits keep no values
+    if (_visitor) return {};
+
+    // Names come sorted, each one is inserted at the end
+    Options out;
+    for (std::uint32_t index : _result_order) {
+        out.emplace_hint(out.end(),
+                         _schema.longOpt(_schema.record(index)),
+                         _record_values[index]);
+    }
+    if (_subcommands.size()) out[_COMMAND_KEY] = _command;
+    return out;
+}
+
+const Argument &ParserImpl::_argument(std::uint32_t index) const {
+    const std::uint32_t n_optional = _schema.optionalCount();
+    if (_arguments_loaded) {
+        return (index < n_optional) ? _optional[index]
+                                    : _required[index - n_optional];
+    }
+
+    // Dispatching needs only this one, the others stay in the schema
+    const schema::Record &r = _schema.record(index);
+    const bool has_choices =
+        _schema.choices(index, &_loaded_argument_choices);
+    _loaded_argument.emplace(Argument{
+        .long_opt = _schema.string(r.long_opt),
+        .short_opt = r.short_opt,
+        .required = (r.flags & schema::FLAG_REQUIRED) != 0,
+        .parameter_required = _schema.parameter(r),
+        .help = _schema.help(index),
+        .default_value = _schema.defaultValue(index),
+        .action = actions::predefined(r.action),
+        .choices = has_choices ? _loaded_argument_choices.data() : nullptr,
+        .env = _schema.env(index),
+    });
+    return *_loaded_argument;
+}
+
+void ParserImpl::_compile() {
+    _custom_actions.clear();
+    schema::build(_optional, _required, &_custom_actions, &_compiled);
+    _schema = schema::View{_compiled.data()};
+    _schema_valid = true;
+    _values_valid = false;
+
+    _providers.clear();
+    _destinations.clear();
+    _bound_variables.clear();
+    _owner = nullptr;
+    for (const auto *args : {&_optional, &_required}) {
+        for (const auto &arg : *args) {
+            const Destination &d = arg.destination;
+            if (d.variable) {
+                _bound_variables.emplace_back(_destinations.size());
+            } else if (d.owner && _owner == nullptr) {
+                _owner = d.owner;
+            } else if (d.owner && d.owner != _owner) {
+                _owner = &_MIXED_OWNERS;
+            }
+
+            _providers.emplace_back(arg.default_provider);
+            _destinations.emplace_back(d);
+        }
+    }
+}
+
+void ParserImpl::_load_arguments() const {
+    if (_arguments_loaded) return;
+
+    _optional.clear();
+    _required.clear();
+    _loaded_choices.clear();
+
+    const std::uint32_t n = _schema.optionalCount() + _schema.requiredCount();
+    for (std::uint32_t i = 0; i < n; ++i) {
+        const schema::Record &r = _schema.record(i);
+
+        const char *const *choices = nullptr;
+        std::vector<const char *> list;
+        if (_schema.choices(i, &list)) {
+            _loaded_choices.emplace_back(std::move(list));
+            choices = _loaded_choices.back().data();
+        }
+
+        const Argument arg = {
+            .long_opt = _schema.string(r.long_opt),
+            .short_opt = r.short_opt,
+            .required = (r.flags & schema::FLAG_REQUIRED) != 0,
+            .parameter_required = _schema.parameter(r),
+            .help = _schema.help(i),
+            .default_value = _schema.defaultValue(i),
+            .action = actions::predefined(r.action),
+            .choices = choices,
+            .env = _schema.env(i),
+        };
+
+        if (arg.required) {
+            _required.emplace_back(arg);
+        } else {
+            _optional.emplace_back(arg);
+        }
+    }
+
+    _arguments_loaded = true;
+}
+
+int ParserImpl::saveSchema(std::ostream *os) {
+    if (_subcommands.size()) return schema::UNSUPPORTED;
+
+    if (!_schema_valid) _compile();
+
+    // Neither custom actions nor default providers nor destinations can be
+    // saved
+    if (_custom_actions.size() ||
+        std::any_of(_providers.begin(), _providers.end(),
+                    [](DefaultProvider p) { return p != nullptr; }) ||
+        std::any_of(_destinations.begin(), _destinations.end(),
+                    [](const Destination &d) { return d.store != nullptr; })) {
+        return schema::UNSUPPORTED;
+    }
+
+    os->write(static_cast<const char *>(_schema.data()), _schema.size());
+    return (*os) ? schema::OK : schema::IO_ERROR;
+}
+
+int ParserImpl::loadSchema(const void *data, std::size_t size) {
+    int res = schema::check(data, size);
+    if (res) return res;
+
+    schema::View loaded{data};
+    if (_subcommands.size() && loaded.requiredCount()) {
+        // Positional arguments are taken by subcommands
+        return schema::UNSUPPORTED;
+    }
+
+    _optional.clear();
+    _required.clear();
+    _loaded_choices.clear();
+    _arguments_loaded = false;
+
+    _names.clear();
+    for (std::uint32_t i = 0;
+         i < loaded.optionalCount() + loaded.requiredCount(); ++i) {
+        _names.insert(loaded.longOpt(loaded.record(i)));
+    }
+    if (_subcommands.size()) _names.insert(_COMMAND_KEY);
+
+    _values_valid = false;
+    _sources.clear();
+    _compiled.clear();
+    _custom_actions.clear();
+    _providers.clear();
+    _computed.clear();
+    _destinations.clear();
+    _bound_variables.clear();
+    _owner = nullptr;
+    _mapping.reset();
+    _schema = loaded;
+    _schema_valid = true;
+
+    _suggestions_valid = false;
+    _help_index_valid = false;
+    _completion_valid = false;
+    _cache.clear();
+    return schema::OK;
+}
+
+int ParserImpl::loadConfig(const std::string &path,
+                           const std::string &section) {
+    if (!_schema_valid) _compile();
+
+    std::vector<config::Value> values;
+    int res = config::load(path, section, _schema, &values);
+    if (res) return res;
+
+    _config = std::move(values);
+    _config_path = path;
+    _config_section = section;
+    _cache.clear();
+
+    // Subcommands already set up read their own section again
+    for (std::size_t i = 0; i < _subparsers.size(); ++i) {
+        if (_subparsers[i]) {
+            _subparsers[i]->loadConfig(path,
+                                       _subsection(_subcommands[i].name));
+        }
+    }
+    return 0;
+}
+
+int ParserImpl::reloadConfig() {
+    if (_config_path.empty()) return 0;
+
+    // Copies, loadConfig assigns both
+    return loadConfig(std::string(_config_path),
+                      std::string(_config_section));
+}
+
+std::string ParserImpl::_subsection(const char *name) const {
+    if (_config_section.empty()) return name;
+    return _config_section + "." + name;
+}
+
+Source ParserImpl::source(const std::string &name) const {
+    // Nothing compiled yet, e.g. before the first parse
+    const std::uint32_t n = _schema.empty() ? 0 : _sources.size();
+
+    std::uint32_t index = n ? _schema.findLong(name) : schema::NONE;
+    for (std::uint32_t i = n ? _schema.optionalCount() : 0;
+         index == schema::NONE && i < n; ++i) {
+        if (_schema.longOpt(_schema.record(i)) == name) index = i;
+    }
+
+    if (index < n) return _sources[index];
+
+    if (_selected >= 0) {
+        if (name == _COMMAND_KEY) return Source::COMMAND_LINE;
+        return _subparsers[_selected]->source(name);
+    }
+
+    return Source::DEFAULT;
+}
+
+int ParserImpl::value(const std::string &name, std::string *out) {
+    // Arguments changed since the last parse, only defaults are left
+    if (!_schema_valid || !_values_valid) clear();
+
+    std::uint32_t index = _schema.empty() ? schema::NONE
+                                          : _schema.findLong(name);
+
+    const std::uint32_t n = _sources.size();
+    for (std::uint32_t i = _schema.optionalCount();
+         index == schema::NONE && i < n; ++i) {
+        if (_schema.longOpt(_schema.record(i)) == name) index = i;
+    }
+
+    if (index >= n) {
+        if (_subcommands.size() && name == _COMMAND_KEY) {
+            *out = _command;
+            return 0;
+        }
+
+        if (_selected >= 0) {
+            return _subparsers[_selected]->value(name, out);
+        }
+        return -1;
+    }
+
+    // Computed only if no layer set a value
+    if (index < _providers.size() && _providers[index] &&
+        _sources[index] == Source::DEFAULT && _computed[index] != DONE) {
+        if (_computed[index] == COMPUTING) {
+            // Depends on itself
+            return -2;
+        }
+
+        _computed[index] = COMPUTING;
+        std::string dest = _schema.defaultValue(index);
+        int res = _providers[index](&dest, this);
+        if (res) {
+            _computed[index] = PENDING;
+            return res;
+        }
+
+        *_modify(index) = std::move(dest);
+        _computed[index] = DONE;
+    }
+
+    *out = _record_values[index];
+    return 0;
+}
+
+std::uint64_t ParserImpl::schemaHash() {
+    if (!_schema_valid) _compile();
+
+    // Subcommands are not part of the schema, but their names and arguments
+    // shape the results all the same (their parsers are set up for this)
+    std::uint64_t hash = _schema.header().checksum;
+    for (std::size_t i = 0; i < _subcommands.size(); ++i) {
+        const char *name = _subcommands[i].name;
+        hash = schema::checksum(name, std::strlen(name) + 1, hash);
+
+        const std::uint64_t sub = _subparser(i)->schemaHash();
+        hash = schema::checksum(&sub, sizeof(sub), hash);
+    }
+    return hash;
+}
+
+int ParserImpl::saveResults(const Options &values, std::string *out) {
+    std::vector<Source> sources;
+    sources.reserve(values.size());
+    for (const auto &entry : values) {
+        sources.push_back(source(entry.first));
+    }
+
+    results::build(values, sources, schemaHash(), out);
+    return 0;
+}
+
+int ParserImpl::validate(session::State *state) {
+    if (_subcommands.size()) return -2;
+
+    if (!_schema_valid) _compile();
+    _load_arguments();
+
+    session::validate(_schema, _optional, _required, _formatter, state);
+    return state->errors.size();
+}
+
+int ParserImpl::mapSchema(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return schema::IO_ERROR;
+
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return schema::IO_ERROR;
+    }
+
+    std::size_t size = st.st_size;
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return schema::IO_ERROR;
+
+    int res = loadSchema(data, size);
+    if (res) {
+        ::munmap(data, size);
+        return res;
+    }
+
+    _mapping = std::shared_ptr<const void>(
+        data, [size](const void *p) { ::munmap(const_cast<void *>(p), size); });
+    return schema::OK;
+}
+
+std::string ParserImpl::getHelp() const {
+    _load_arguments();
+
+    std::ostringstream oss;
+    _formatter.formatHelp(&oss, _required, _optional, _subcommands);
+    return oss.str();
+}
+
+std::string ParserImpl::searchHelp(const std::string &term) const {
+    std::ostringstream oss;
+    _search_help(&oss, term);
+    return oss.str();
+}
+
+void ParserImpl::_search_help(std::ostream *os, std::string_view term) const {
+    _load_arguments();
+
+    if (!_help_index_valid) {
+        _help_arguments.clear();
+        for (const auto *list : {&_optional, &_required}) {
+            for (const auto &arg : *list) _help_arguments.push_back(&arg);
+        }
+
+        _help_index.build(_help_arguments);
+        _help_index_valid = true;
+    }
+
+    std::vector<const Argument *> matches;
+    for (auto index : _help_index.search(term)) {
+        matches.push_back(_help_arguments[index]);
+    }
+
+    if (matches.empty()) {
+        *os << "No options matching '" << term << "'" << std::endl;
+        return;
+    }
+    _formatter.formatArguments(os, matches);
+}
+
+std::vector<std::string> ParserImpl::complete(int argc, char *const argv[]) {
+    std::vector<std::string> out;
+    _load_arguments();
+    if (!_completion_valid) _build_completion();
+
+    std::string current = (argc > 1) ? argv[argc - 1] : "";
+    bool options_done = false;
+    int pending = -1;
+
+    // Find out whether the current word is the parameter of an option
+    for (int i = 1; i < argc - 1; ++i) {
+        std::string word = argv[i];
+
+        if (pending >= 0) {
+            pending = -1;
+            continue;
+        }
+
+        if (options_done || word.length() < 2 || word[0] != '-') {
+            if (_subcommands.empty()) continue;
+
+            // The first positional selects the subcommand, which completes
+            // the rest of the command line on its own
+            int index = _completion_commands.find(word);
+            if (index < 0) return out;
+            return _subparser(index)->complete(argc - i, argv + i);
+        }
+
+        if (word == "--") {
+            options_done = true;
+            continue;
+        }
+
+        if (word[1] == '-') {
+            int index = _completion_options.find(word);
+            if (index >= 0 && _optional[index].parameter_required ==
+                                  Argument::ParameterRequired::REQUIRED) {
+                pending = index;
+            }
+            continue;
+        }
+
+        // Cluster of short options, the first one accepting a parameter
+        // takes the rest of the word (or the next one)
+        for (std::size_t j = 1; j < word.length(); ++j) {
+            int index = _completion_options.find(std::string("-") + word[j]);
+            if (index < 0) break;
+
+            auto parameter = _optional[index].parameter_required;
+            if (parameter == Argument::ParameterRequired::NO) continue;
+            if (parameter == Argument::ParameterRequired::REQUIRED &&
+                j + 1 == word.length()) {
+                pending = index;
+            }
+            break;
+        }
+    }
+
+    if (pending >= 0) {
+        std::string prefix =
+            "--" + std::string(_optional[pending].long_opt) + "=";
+        _completion_values.complete(prefix + current, &out);
+        for (auto &candidate : out) {
+            candidate.erase(0, prefix.length());
+        }
+    } else if (!options_done && current.length() && current[0] == '-') {
+        if (current.find('=') != std::string::npos) {
+            _completion_values.complete(current, &out);
+        } else {
+            _completion_options.complete(current, &out);
+        }
+    } else {
+        _completion_commands.complete(current, &out);
+    }
+
+    return out;
+}
+
+void ParserImpl::_build_completion() {
+    std::vector<Trie::Entry> options;
+    std::vector<Trie::Entry> values;
+
+    for (int i = 0; i < static_cast<int>(_optional.size()); ++i) {
+        const Argument &arg = _optional[i];
+        std::string long_opt = "--" + std::string(arg.long_opt);
+
+        options.emplace_back(long_opt, i);
+        if (arg.short_opt) {
+            options.emplace_back(std::string("-") + arg.short_opt, i);
+        }
+
+        for (auto choice = arg.choices; choice && *choice; ++choice) {
+            values.emplace_back(long_opt + "=" + *choice, i);
+        }
+    }
+
+    std::vector<Trie::Entry> commands;
+    for (int i = 0; i < static_cast<int>(_subcommands.size()); ++i) {
+        commands.emplace_back(_subcommands[i].name, i);
+    }
+
+    _completion_options.build(std::move(options));
+    _completion_values.build(std::move(values));
+    _completion_commands.build(std::move(commands));
+    _completion_valid = true;
+}
+
+bool ParserImpl::_handle_completion_request(int argc, char *const argv[]) {
+    if (argc < 2) return false;
+
+    if (std::strcmp(argv[1], completion::REQUEST) == 0) {
+        for (const auto &candidate : complete(argc - 1, argv + 1)) {
+            std::cout << candidate << '\n';
+        }
+        std::cout << std::flush;
+        return true;
+    }
+
+    completion::Shell shell;
+    if (std::strcmp(argv[1], completion::SCRIPT_REQUEST) == 0 && argc > 2 &&
+        completion::shellFromName(argv[2], &shell)) {
+        std::cout << completion::script(shell, argv[0]) << std::flush;
+        return true;
+    }
+
+    return false;
+}
+
+const ParseError &ParserImpl::lastError() const {
+    return _error;
+}
+
+void ParserImpl::setErrorHandler(ErrorHandler handler) {
+    _error_handler = handler;
+    for (auto &sub : _subparsers) {
+        if (sub) sub->setErrorHandler(handler);
+    }
+}
+
+ErrorHandler ParserImpl::errorHandler() const {
+    return _error_handler;
+}
+
+void ParserImpl::setExitOnHelp(bool exit) {
+    _exit_on_help = exit;
+    for (auto &sub : _subparsers) {
+        if (sub) sub->setExitOnHelp(exit);
+    }
+}
+
+bool ParserImpl::exitOnHelp() const {
+    return _exit_on_help;
+}
+
+int ParserImpl::_run_action(const Argument &arg_options,
+                            const std::string &src, std::string *dest) {
+    int res = arg_options.action(dest, arg_options, src);
+    if (res > 0) {
+        _error.kind = ParseError::Kind::INVALID_VALUE;
+        _error.token = src;
+        if (arg_options.choices) {
+            _error.suggestions =
+                SuggestionIndex{arg_options.choices}.suggest(src);
+        }
+    }
+    return res;
+}
+
+void ParserImpl::_suggest_option(std::string_view name) {
+    if (!_suggestions_valid) {
+        _suggestions.clear();
+        for (std::uint32_t i = 0; i < _schema.optionalCount(); ++i) {
+            _suggestions.add(_schema.longOpt(_schema.record(i)));
+        }
+        _suggestions_valid = true;
+    }
+
+    for (auto &suggestion : _suggestions.suggest(name)) {
+        _error.suggestions.emplace_back("--" + suggestion);
+    }
+}
+
+Options ParserImpl::_fail(std::string_view prog) {
+    if (_error_handler) {
+        _error_handler(_error);
+        return _results();
+    }
+
+    // Subcommands are named after the full command line that selects them
+    if (_formatter.params().prog.length()) {
+        prog = _formatter.params().prog;
+    }
+
+    switch (_error.kind) {
+        case ParseError::Kind::UNKNOWN_OPTION:
+            std::cerr << prog << ": unrecognized option '" << _error.token
+                      << "'" << std::endl;
+            break;
+        case ParseError::Kind::AMBIGUOUS_OPTION:
+            std::cerr << prog << ": option '" << _error.token
+                      << "' is ambiguous" << std::endl;
+            break;
+        case ParseError::Kind::MISSING_PARAMETER:
+            std::cerr << prog << ": option '" << _error.token
+                      << "' requires an argument" << std::endl;
+            break;
+        case ParseError::Kind::UNEXPECTED_PARAMETER:
+            std::cerr << prog << ": option '" << _error.token
+                      << "' doesn't allow an argument" << std::endl;
+            break;
+        case ParseError::Kind::TOO_MANY_ARGUMENTS:
+            std::cerr << prog << ": too many required options: "
+                      << _error.token << std::endl;
+            break;
+        case ParseError::Kind::MISSING_ARGUMENTS:
+            std::cerr << prog << ": missing required options: "
+                      << _error.token << std::endl;
+            break;
+        case ParseError::Kind::UNKNOWN_COMMAND:
+            std::cerr << prog << ": unknown command '" << _error.token << "'"
+                      << std::endl;
+            break;
+        case ParseError::Kind::INVALID_COMMAND_LINE:
+            std::cerr << prog << ": cannot split command line '"
+                      << _error.token << "'" << std::endl;
+            break;
+        case ParseError::Kind::ARENA_EXHAUSTED:
+            std::cerr << prog << ": not enough memory to split command line '"
+                      << _error.token << "'" << std::endl;
+            break;
+        case ParseError::Kind::HELP_REQUESTED:
+            std::cerr << prog << ": help is not available here" << std::endl;
+            break;
+        case ParseError::Kind::NAME_CONFLICT:
+            std::cerr << prog << ": option '" << _error.token
+                      << "' of command '" << _subcommands[_selected].name
+                      << "' is already an option of '" << prog << "'"
+                      << std::endl;
+            break;
+        default:
+            // Actions print their own error messages
+            break;
+    }
+
+    if (_error.suggestions.size() == 1) {
+        std::cerr << std::endl;
+        std::cerr << "Did you mean '" << _error.suggestions.front() << "'?"
+                  << std::endl;
+    } else if (_error.suggestions.size() > 1) {
+        std::cerr << std::endl;
+        std::cerr << "Did you mean one of these?" << std::endl;
+        for (const auto &suggestion : _error.suggestions) {
+            std::cerr << "    " << suggestion << std::endl;
+        }
+    }
+
+    // Mistyped options only get a hint, the full help would bury them
+    bool full_help = _error.kind == ParseError::Kind::INVALID_VALUE ||
+                     _error.kind == ParseError::Kind::TOO_MANY_ARGUMENTS ||
+                     _error.kind == ParseError::Kind::MISSING_ARGUMENTS;
+
+    std::cerr << std::endl;
+    if (full_help) {
+        _load_arguments();
+        _formatter.formatHelp(&std::cerr, _required, _optional,
+                              _subcommands);
+    } else {
+        std::cerr << "Try '" << prog << " --help' for more information."
+                  << std::endl;
+    }
+    std::exit(EXIT_FAILURE);
+}
+
+Parser::Parser(const HelpFormatter::Params &p) {
+    _impl = std::make_unique<ParserImpl>(p);
 }
 
 Parser::Parser(const HelpFormatter &fmt) {
     _impl = std::make_unique<ParserImpl>(fmt);
 }
 
+Parser::~Parser() noexcept = default;
+
+Parser::Parser(Parser &&rhs) noexcept = default;
+Parser &Parser::operator=(Parser &&rhs) noexcept = default;
+
+int Parser::_validate(session::State *state) {
+    return _impl->validate(state);
+}
+
+int Parser::addArgument(const Argument &arg_options) {
+    return _impl->addArgument(arg_options);
+}
+
+int Parser::addArguments(const Argument args[], std::size_t count) {
+    return _impl->addArguments(args, count);
+}
+
+int Parser::addSubcommand(const Subcommand &cmd) {
+    return _impl->addSubcommand(cmd);
+}
+
+Options Parser::parse(int argc, char *const argv[]) {
+    return _impl->parse(argc, argv);
+}
+
+Options Parser::parse(int argc, const std::string_view argv[]) {
+    return _impl->parse(argc, argv);
+}
+
+Options Parser::parse(std::string_view cmdline, Arena *arena) {
+    return _impl->parse(cmdline, arena);
+}
+
+std::shared_ptr<const Options> Parser::parseCached(int argc,
+                                                   char *const argv[]) {
+    return _impl->parseCached(argc, argv);
+}
+
+std::shared_ptr<const Options> Parser::parseCached(
+    int argc, const std::string_view argv[]) {
+    return _impl->parseCached(argc, argv);
+}
+
+void Parser::setCacheCapacity(std::size_t bytes) {
+    _impl->setCacheCapacity(bytes);
+}
+
+CacheStats Parser::cacheStats() const {
+    return _impl->cacheStats();
+}
+
+Options Parser::parseNamespace(int argc, const std::string_view argv[],
+                               std::string_view name_space) {
+    return _impl->parseNamespace(argc, argv, name_space);
+}
+
+int Parser::visit(int argc, char *const argv[], Visitor *visitor) {
+    return _impl->visit(argc, argv, visitor);
+}
+
+int Parser::visit(int argc, const std::string_view argv[], Visitor *visitor) {
+    return _impl->visit(argc, argv, visitor);
+}
+
+std::uint32_t Parser::argumentId(std::string_view name) {
+    return _impl->argumentId(name);
+}
+
+int Parser::bindDefaults(void *base, const void *owner) {
+    return _impl->bindDefaults(base, owner);
+}
+
+int Parser::parseInto(int argc, char *const argv[], void *base,
+                      const void *owner) {
+    return _impl->parseInto(argc, argv, base, owner);
+}
+
+int Parser::parseInto(int argc, const std::string_view argv[], void *base,
+                      const void *owner) {
+    return _impl->parseInto(argc, argv, base, owner);
+}
+
+void Parser::clear() {
+    _impl->clear();
+}
+
+std::string Parser::getHelp() const {
+    return _impl->getHelp();
+}
+
+std::string Parser::searchHelp(const std::string &term) const {
+    return _impl->searchHelp(term);
+}
+
+std::vector<std::string> Parser::complete(int argc, char *const argv[]) {
+    return _impl->complete(argc, argv);
+}
+
+const ParseError &Parser::lastError() const {
+    return _impl->lastError();
+}
+
+void Parser::setErrorHandler(ErrorHandler handler) {
+    _impl->setErrorHandler(handler);
+}
+
+ErrorHandler Parser::errorHandler() const {
+    return _impl->errorHandler();
+}
+
+void Parser::setExitOnHelp(bool exit) {
+    _impl->setExitOnHelp(exit);
+}
+
+bool Parser::exitOnHelp() const {
+    return _impl->exitOnHelp();
+}
+
+int Parser::saveSchema(std::ostream *os) {
+    return _impl->saveSchema(os);
+}
+
+int Parser::loadSchema(const void *data, std::size_t size) {
+    return _impl->loadSchema(data, size);
+}
+
+int Parser::mapSchema(const std::string &path) {
+    return _impl->mapSchema(path);
+}
+
+int Parser::loadConfig(const std::string &path, const std::string &section) {
+    return _impl->loadConfig(path, section);
+}
+
+int Parser::reloadConfig() {
+    return _impl->reloadConfig();
+}
+
+Source Parser::source(const std::string &name) const {
+    return _impl->source(name);
+}
+
+int Parser::value(const std::string &name, std::string *out) {
+    return _impl->value(name, out);
+}
+
+std::uint64_t Parser::schemaHash() {
+    return _impl->schemaHash();
+}
+
+int Parser::saveResults(const Options &values, std::string *out) {
+    return _impl->saveResults(values, out);
+}
+
 }  // namespace cmdarg
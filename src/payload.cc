@@ -0,0 +1,111 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include <cmdarg/payload.hpp>
+
+namespace cmdarg {
+
+int Payload::read(std::string_view *out) const {
+    if (!isFile()) {
+        // Inline value, "@@" escapes a leading '@'
+        *out = _value;
+        if (_value.size() > 1 && _value[0] == '@') out->remove_prefix(1);
+        return 0;
+    }
+
+    if (_loaded) {
+        *out = _content;
+        return 0;
+    }
+
+    const std::string file = path();
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    struct ::stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        _error = "cannot open '" + file + "': " + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        // Pipes and devices (e.g. @/dev/stdin) report no size, and cannot
+        // be mapped
+        int res = _read_stream(fd, file);
+        ::close(fd);
+        if (res) return res;
+
+        _loaded = true;
+        _error.clear();
+        *out = _content;
+        return 0;
+    }
+
+    std::size_t size = st.st_size;
+    if (size > _max_size) {
+        ::close(fd);
+        _error = "'" + file + "' is too large (" + std::to_string(size) +
+                 " bytes, at most " + std::to_string(_max_size) + ")";
+        return -2;
+    }
+
+    if (size > 0) {
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            _error = "cannot map '" + file + "': " + std::strerror(errno);
+            ::close(fd);
+            return -5;
+        }
+
+        _mapping = std::shared_ptr<const void>(data, [size](const void *p) {
+            ::munmap(const_cast<void *>(p), size);
+        });
+        _content = {static_cast<const char *>(data), size};
+    }
+    ::close(fd);
+
+    _loaded = true;
+    _error.clear();
+    *out = _content;
+    return 0;
+}
+
+int Payload::_read_stream(int fd, const std::string &file) const {
+    auto buffer = std::make_shared<std::string>();
+    char chunk[4096];
+
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            _error = "cannot read '" + file + "': " + std::strerror(errno);
+            return -3;
+        }
+        if (n == 0) break;
+
+        if (buffer->size() + n > _max_size) {
+            _error = "'" + file + "' is too large (more than " +
+                     std::to_string(_max_size) + " bytes)";
+            return -2;
+        }
+        buffer->append(chunk, n);
+    }
+
+    _content = *buffer;
+    _mapping = std::shared_ptr<const void>(buffer, buffer->data());
+    return 0;
+}
+
+}  // namespace cmdarg
@@ -0,0 +1,101 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/process.hpp>
+
+namespace cmdarg::process {
+
+struct CommandLine {
+    std::unique_ptr<char[]> data;
+    std::vector<std::string_view> words;
+};
+
+static CommandLine _read() {
+    CommandLine out;
+
+    int fd = ::open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return out;
+
+    // Files in /proc report no size, read until the end doubling the buffer
+    std::size_t capacity = 4096;
+    std::size_t size = 0;
+    out.data = std::make_unique<char[]>(capacity);
+
+    for (;;) {
+        if (size == capacity) {
+            auto data = std::make_unique<char[]>(2 * capacity);
+            std::memcpy(data.get(), out.data.get(), size);
+            out.data = std::move(data);
+            capacity *= 2;
+        }
+
+        ssize_t res = ::read(fd, out.data.get() + size, capacity - size);
+        if (res < 0 && errno == EINTR) continue;
+        if (res < 0) {
+            ::close(fd);
+            return CommandLine{};
+        }
+        if (res == 0) break;
+        size += res;
+    }
+    ::close(fd);
+
+    // Every word is NUL-terminated
+    const char *data = out.data.get();
+    for (std::size_t begin = 0; begin < size;) {
+        const void *end = std::memchr(data + begin, '\0', size - begin);
+        const std::size_t length =
+            end ? static_cast<const char *>(end) - (data + begin)
+                : size - begin;
+
+        out.words.emplace_back(data + begin, length);
+        begin += length + 1;
+    }
+
+    return out;
+}
+
+static const CommandLine &_command_line() {
+    // Initialized once, even with concurrent callers
+    static const CommandLine command_line = _read();
+    return command_line;
+}
+
+int arguments(const std::string_view **argv) {
+    const CommandLine &command_line = _command_line();
+    *argv = command_line.words.data();
+    return command_line.words.size();
+}
+
+// Errors are left in lastError(), for the library to handle
+static void _keep_error(const ParseError & /*err*/) {
+}
+
+Options parse(Parser *parser, std::string_view name_space) {
+    const std::string_view *argv;
+    int argc = arguments(&argv);
+
+    // The default handler would terminate the host program, and so would
+    // help requests
+    const ErrorHandler handler = parser->errorHandler();
+    const bool exit_on_help = parser->exitOnHelp();
+    if (handler == nullptr) parser->setErrorHandler(_keep_error);
+    parser->setExitOnHelp(false);
+    Options values = parser->parseNamespace(argc, argv, name_space);
+    parser->setExitOnHelp(exit_on_help);
+    if (handler == nullptr) parser->setErrorHandler(nullptr);
+    return values;
+}
+
+}  // namespace cmdarg::process
@@ -0,0 +1,115 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Project headers
+#include <cmdarg/registry.hpp>
+
+namespace cmdarg {
+
+namespace registry {
+
+// Constant-initialized, hence already null when the first block links
+// itself; blocks are kept in merge order, see _before
+static OptionBlock *_head = nullptr;
+
+// Blocks linked so far, a different count when merged means new ones
+static std::size_t _count = 0;
+
+// Registration happens before main, but libraries loaded later (dlopen) can
+// still add blocks, so the list is protected anyway
+static std::mutex _mutex;
+
+struct Merged {
+    // Value of _count when merged
+    std::size_t blocks = 0;
+
+    // Full names of namespaced options, never reallocated once filled
+    std::vector<std::string> names;
+    std::vector<Argument> arguments;
+};
+
+// Built on first use, after every block of the program linked itself (and
+// whatever the order of static initialization across translation units)
+static Merged &_merged() {
+    static Merged merged;
+    return merged;
+}
+
+static bool _before(const OptionBlock *lhs, const OptionBlock *rhs) {
+    const char *lhs_ns = lhs->nameSpace() ? lhs->nameSpace() : "";
+    const char *rhs_ns = rhs->nameSpace() ? rhs->nameSpace() : "";
+
+    int res = std::strcmp(lhs_ns, rhs_ns);
+    if (res) return res < 0;
+
+    // Same namespace in more translation units: by first option name
+    if (lhs->count() == 0 || rhs->count() == 0)
+        return lhs->count() < rhs->count();
+    const char *lhs_opt = lhs->arguments()[0].long_opt;
+    const char *rhs_opt = rhs->arguments()[0].long_opt;
+    return std::strcmp(lhs_opt ? lhs_opt : "", rhs_opt ? rhs_opt : "") < 0;
+}
+
+static void _merge(Merged *merged) {
+    std::size_t count = 0;
+    for (const OptionBlock *block = _head; block; block = block->next()) {
+        count += block->count();
+    }
+
+    merged->blocks = _count;
+    merged->names.clear();
+    merged->names.reserve(count);
+    merged->arguments.clear();
+    merged->arguments.reserve(count);
+
+    // Blocks are already in order, options keep theirs
+    for (const OptionBlock *block = _head; block; block = block->next()) {
+        const char *ns = block->nameSpace();
+
+        for (std::size_t i = 0; i < block->count(); ++i) {
+            const Argument &arg = block->arguments()[i];
+            const char *long_opt = arg.long_opt;
+
+            if (ns && *ns && long_opt) {
+                merged->names.emplace_back(std::string(ns) + "." + long_opt);
+                long_opt = merged->names.back().c_str();
+            }
+
+            // Everything else as declared, whatever fields Argument gains
+            merged->arguments.push_back(arg);
+            merged->arguments.back().long_opt = long_opt;
+        }
+    }
+}
+
+int apply(Parser *parser) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    Merged &merged = _merged();
+    if (merged.blocks != _count) _merge(&merged);
+
+    return parser->addArguments(merged.arguments.data(),
+                                merged.arguments.size());
+}
+
+}  // namespace registry
+
+void OptionBlock::_link() {
+    std::lock_guard<std::mutex> lock{registry::_mutex};
+
+    // After the blocks that come before it or tie with it; programs have a
+    // handful of blocks, the walk is short
+    OptionBlock **link = &registry::_head;
+    while (*link && !registry::_before(this, *link)) link = &(*link)->_next;
+
+    _next = *link;
+    *link = this;
+    ++registry::_count;
+}
+
+}  // namespace cmdarg
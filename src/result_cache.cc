@@ -0,0 +1,100 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+// Project headers
+#include <cmdarg/result_cache.hpp>
+#include <cmdarg/schema.hpp>
+
+namespace cmdarg {
+
+// Rough cost of an entry and of each value beyond its strings: list and tree
+// nodes, string headers
+static constexpr std::size_t _ENTRY_OVERHEAD =
+    128 + sizeof(Options) + sizeof(std::string);
+static constexpr std::size_t _VALUE_OVERHEAD =
+    32 + sizeof(Options::value_type);
+
+static std::size_t _footprint(std::string_view key, const Options &values) {
+    std::size_t bytes = _ENTRY_OVERHEAD + key.size();
+    for (const auto &[name, value] : values) {
+        bytes += _VALUE_OVERHEAD + name.size() + value.size();
+    }
+    return bytes;
+}
+
+std::uint64_t ResultCache::hash(std::string_view key) {
+    return schema::checksum(key.data(), key.size());
+}
+
+void ResultCache::setCapacity(std::size_t bytes) {
+    _capacity = bytes;
+    _evict(_capacity);
+}
+
+ResultCache::Result ResultCache::find(std::string_view key,
+                                      std::uint64_t hash) {
+    auto found = _index.find(hash);
+    if (found == _index.end() || found->second->key != key) {
+        ++_misses;
+        return nullptr;
+    }
+
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, found->second);
+    return found->second->result;
+}
+
+void ResultCache::insert(std::string_view key, std::uint64_t hash,
+                         Result result) {
+    const std::size_t bytes = _footprint(key, *result);
+    if (bytes > _capacity) return;
+
+    auto found = _index.find(hash);
+    if (found != _index.end()) _erase(found->second);
+
+    _evict(_capacity - bytes);
+    _entries.push_front(Entry{
+        .key = std::string(key),
+        .hash = hash,
+        .result = std::move(result),
+        .bytes = bytes,
+    });
+    _index[hash] = _entries.begin();
+    _bytes += bytes;
+}
+
+void ResultCache::clear() {
+    _entries.clear();
+    _index.clear();
+    _bytes = 0;
+}
+
+CacheStats ResultCache::stats() const {
+    return {
+        .hits = _hits,
+        .misses = _misses,
+        .entries = _entries.size(),
+        .bytes = _bytes,
+    };
+}
+
+void ResultCache::_erase(std::list<Entry>::iterator it) {
+    _bytes -= it->bytes;
+    _index.erase(it->hash);
+    _entries.erase(it);
+}
+
+void ResultCache::_evict(std::size_t capacity) {
+    while (_bytes > capacity) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+}  // namespace cmdarg
@@ -0,0 +1,317 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/results.hpp>
+#include <cmdarg/results_image.hpp>
+#include <cmdarg/schema.hpp>
+
+namespace cmdarg {
+
+namespace results {
+
+// Checksum of a whole image, header included (with its checksum field taken
+// as zero)
+static std::uint64_t _image_checksum(const char *base, std::uint64_t size) {
+    Header h;
+    std::memcpy(&h, base, sizeof(Header));
+    h.checksum = 0;
+
+    return schema::checksum(base + sizeof(Header), size - sizeof(Header),
+                            schema::checksum(&h, sizeof(Header)));
+}
+
+void build(const Options &values, const std::vector<Source> &sources,
+           std::uint64_t schema_hash, std::string *out) {
+    std::vector<Entry> entries;
+    std::string strings;
+
+    for (const auto &[key, value] : values) {
+        Entry e = {
+            .key = static_cast<std::uint32_t>(strings.size()),
+            .value = static_cast<std::uint32_t>(strings.size() + key.size() +
+                                                1),
+            .key_length = static_cast<std::uint32_t>(key.size()),
+            .value_length = static_cast<std::uint32_t>(value.size()),
+            .source = static_cast<std::uint32_t>(
+                (entries.size() < sources.size()) ? sources[entries.size()]
+                                                  : Source::DEFAULT),
+        };
+        strings.append(key);
+        strings.push_back('\0');
+        strings.append(value.data(), value.size());
+        strings.push_back('\0');
+        entries.emplace_back(e);
+    }
+
+    const std::uint32_t strings_at =
+        sizeof(Header) + entries.size() * sizeof(Entry);
+
+    Header h = {
+        .magic = {},
+        .version = VERSION,
+        .byte_order = BYTE_ORDER_MARK,
+        .size = (strings_at + strings.size() + 7) / 8 * 8,
+        // Computed once the image is complete
+        .checksum = 0,
+        .schema_hash = schema_hash,
+        .n_values = static_cast<std::uint32_t>(entries.size()),
+        .entries = sizeof(Header),
+        .strings = strings_at,
+        .strings_size = static_cast<std::uint32_t>(strings.size()),
+    };
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+
+    out->assign(h.size, '\0');
+    char *base = out->data();
+    if (entries.size()) {
+        std::memcpy(base + h.entries, entries.data(),
+                    entries.size() * sizeof(Entry));
+    }
+    std::memcpy(base + h.strings, strings.data(), strings.size());
+
+    std::memcpy(base, &h, sizeof(Header));
+    h.checksum = _image_checksum(base, h.size);
+    std::memcpy(base, &h, sizeof(Header));
+}
+
+static const char _BASE64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int toMemfd(const std::string &image) {
+    // Not close-on-exec: workers inherit it
+    int fd = ::memfd_create("cmdarg-results", MFD_ALLOW_SEALING);
+    if (fd < 0) return schema::IO_ERROR;
+
+    for (std::size_t done = 0; done < image.size();) {
+        ssize_t res = ::write(fd, image.data() + done, image.size() - done);
+        if (res <= 0) {
+            ::close(fd);
+            return schema::IO_ERROR;
+        }
+        done += res;
+    }
+
+    // Workers can trust the image will never change under them
+    if (::fcntl(fd, F_ADD_SEALS,
+                F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)) {
+        ::close(fd);
+        return schema::IO_ERROR;
+    }
+
+    return fd;
+}
+
+int toEnv(const char *name, const std::string &image) {
+    std::string encoded;
+    encoded.reserve((image.size() + 2) / 3 * 4);
+
+    for (std::size_t i = 0; i < image.size(); i += 3) {
+        std::uint32_t chunk = static_cast<unsigned char>(image[i]) << 16;
+        if (i + 1 < image.size())
+            chunk |= static_cast<unsigned char>(image[i + 1]) << 8;
+        if (i + 2 < image.size())
+            chunk |= static_cast<unsigned char>(image[i + 2]);
+
+        encoded.push_back(_BASE64[(chunk >> 18) & 0x3F]);
+        encoded.push_back(_BASE64[(chunk >> 12) & 0x3F]);
+        encoded.push_back((i + 1 < image.size()) ? _BASE64[(chunk >> 6) & 0x3F]
+                                                 : '=');
+        encoded.push_back((i + 2 < image.size()) ? _BASE64[chunk & 0x3F]
+                                                 : '=');
+    }
+
+    if (::setenv(name, encoded.c_str(), 1)) return schema::IO_ERROR;
+    return schema::OK;
+}
+
+static bool _decode(std::string_view encoded, std::vector<std::uint64_t> *out) {
+    if (encoded.size() % 4) return false;
+
+    std::size_t size = encoded.size() / 4 * 3;
+    if (encoded.size() && encoded.back() == '=') --size;
+    if (encoded.size() > 1 && encoded[encoded.size() - 2] == '=') --size;
+
+    out->assign((size + 7) / 8, 0);
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(out->data());
+
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < encoded.size(); i += 4) {
+        std::uint32_t chunk = 0;
+        for (std::size_t j = 0; j < 4; ++j) {
+            const char c = encoded[i + j];
+            const char *pos = std::strchr(_BASE64, c);
+            if (c == '=' && i + 4 == encoded.size() && j >= 2) {
+                pos = _BASE64;
+            } else if (c == '\0' || pos == nullptr) {
+                return false;
+            }
+            chunk = (chunk << 6) | (pos - _BASE64);
+        }
+
+        for (int shift = 16; shift >= 0 && written < size; shift -= 8) {
+            bytes[written++] = (chunk >> shift) & 0xFF;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace results
+
+int ResultsView::open(const void *data, std::size_t size,
+                      std::uint64_t schema_hash) {
+    using results::Entry;
+    using results::Header;
+
+    if (data == nullptr || size < sizeof(Header) ||
+        reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t)) {
+        return schema::INVALID;
+    }
+
+    const Header &h = *static_cast<const Header *>(data);
+    if (std::memcmp(h.magic, results::MAGIC, sizeof(results::MAGIC)) != 0)
+        return schema::INVALID;
+    if (h.byte_order != results::BYTE_ORDER_MARK)
+        return schema::UNSUPPORTED_VERSION;
+    if (h.version != results::VERSION) return schema::UNSUPPORTED_VERSION;
+    if (h.size < sizeof(Header) || h.size > size) return schema::INVALID;
+
+    const char *base = static_cast<const char *>(data);
+    if (results::_image_checksum(base, h.size) != h.checksum)
+        return schema::CORRUPTED;
+    if (h.schema_hash != schema_hash) return schema::UNSUPPORTED;
+
+    // The checksum matches, still never trust offsets blindly
+    if (h.entries < sizeof(Header) || h.entries % alignof(Entry) ||
+        h.entries > h.size ||
+        std::uint64_t(h.n_values) * sizeof(Entry) > h.size - h.entries ||
+        h.strings > h.size || h.strings_size > h.size - h.strings ||
+        (h.strings_size && base[h.strings + h.strings_size - 1] != '\0')) {
+        return schema::INVALID;
+    }
+
+    const Entry *entries = reinterpret_cast<const Entry *>(base + h.entries);
+    for (std::uint32_t i = 0; i < h.n_values; ++i) {
+        const Entry &e = entries[i];
+        if (e.key >= h.strings_size || e.value >= h.strings_size ||
+            e.key_length >= h.strings_size - e.key ||
+            e.value_length >= h.strings_size - e.value ||
+            e.source > static_cast<std::uint32_t>(Source::COMMAND_LINE)) {
+            return schema::INVALID;
+        }
+    }
+
+    _storage.reset();
+    _base = base;
+    return schema::OK;
+}
+
+int ResultsView::mapFd(int fd, std::uint64_t schema_hash) {
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) return schema::IO_ERROR;
+
+    std::size_t size = st.st_size;
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return schema::IO_ERROR;
+
+    int res = open(data, size, schema_hash);
+    if (res) {
+        ::munmap(data, size);
+        return res;
+    }
+
+    _storage = std::shared_ptr<const void>(
+        data, [size](const void *p) { ::munmap(const_cast<void *>(p), size); });
+    return schema::OK;
+}
+
+int ResultsView::fromEnv(const char *name, std::uint64_t schema_hash) {
+    const char *encoded = std::getenv(name);
+    if (encoded == nullptr) return schema::IO_ERROR;
+
+    auto buffer = std::make_shared<std::vector<std::uint64_t>>();
+    if (!results::_decode(encoded, buffer.get())) return schema::INVALID;
+
+    int res = open(buffer->data(), buffer->size() * sizeof(std::uint64_t),
+                   schema_hash);
+    if (res) return res;
+
+    _storage = std::shared_ptr<const void>(buffer, buffer->data());
+    return schema::OK;
+}
+
+std::size_t ResultsView::size() const {
+    if (empty()) return 0;
+    return reinterpret_cast<const results::Header *>(_base)->n_values;
+}
+
+static inline const results::Entry &_entry(const char *base,
+                                           std::size_t index) {
+    const auto &h = *reinterpret_cast<const results::Header *>(base);
+    return reinterpret_cast<const results::Entry *>(base + h.entries)[index];
+}
+
+static inline const char *_string(const char *base, std::uint32_t offset) {
+    const auto &h = *reinterpret_cast<const results::Header *>(base);
+    return base + h.strings + offset;
+}
+
+std::string_view ResultsView::key(std::size_t index) const {
+    const results::Entry &e = _entry(_base, index);
+    return {_string(_base, e.key), e.key_length};
+}
+
+std::string_view ResultsView::value(std::size_t index) const {
+    const results::Entry &e = _entry(_base, index);
+    return {_string(_base, e.value), e.value_length};
+}
+
+Source ResultsView::source(std::size_t index) const {
+    return static_cast<Source>(_entry(_base, index).source);
+}
+
+std::size_t ResultsView::_find(std::string_view name) const {
+    std::size_t lo = 0;
+    std::size_t hi = size();
+
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (key(mid) < name) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return (lo < size() && key(lo) == name) ? lo : size();
+}
+
+const char *ResultsView::get(std::string_view name) const {
+    std::size_t index = _find(name);
+    return (index < size()) ? _string(_base, _entry(_base, index).value)
+                            : nullptr;
+}
+
+Options ResultsView::toOptions() const {
+    Options out;
+    for (std::size_t i = 0; i < size(); ++i) {
+        out.emplace_hint(out.end(), key(i), value(i));
+    }
+    return out;
+}
+
+}  // namespace cmdarg
@@ -0,0 +1,408 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Project headers
+#include <cmdarg/actions.hpp>
+#include <cmdarg/schema.hpp>
+
+namespace cmdarg::schema {
+
+std::uint32_t hashName(std::string_view name) {
+    // FNV-1a
+    std::uint32_t h = 2166136261U;
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+std::uint64_t checksum(const void *bytes, std::size_t size,
+                       std::uint64_t seed) {
+    const char *data = static_cast<const char *>(bytes);
+    std::uint64_t h = seed;
+    std::size_t i = 0;
+
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h ^= word;
+        h *= 1099511628211ULL;
+    }
+    for (; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+// Checksum of a whole schema, header included (with its checksum field
+// taken as zero)
+static std::uint64_t _blob_checksum(const char *base, std::uint64_t size) {
+    Header h;
+    std::memcpy(&h, base, sizeof(Header));
+    h.checksum = 0;
+
+    return checksum(base + sizeof(Header), size - sizeof(Header),
+                    checksum(&h, sizeof(Header)));
+}
+
+static std::uint32_t _align(std::uint32_t offset, std::uint32_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Deduplicated pool of NUL-terminated strings
+class StringPool {
+    std::string _data;
+    std::unordered_map<std::string, std::uint32_t> _offsets;
+
+ public:
+    std::uint32_t add(const char *s) {
+        if (s == nullptr) s = "";
+
+        auto it = _offsets.find(s);
+        if (it != _offsets.end()) return it->second;
+
+        std::uint32_t offset = _data.size();
+        _data.append(s);
+        _data.push_back('\0');
+        _offsets.emplace(s, offset);
+        return offset;
+    }
+
+    inline const std::string &data() const {
+        return _data;
+    }
+};
+
+int build(const std::vector<Argument> &optional,
+          const std::vector<Argument> &required,
+          std::vector<actions::Type> *custom_actions,
+          std::vector<std::uint64_t> *out) {
+    StringPool strings;
+    std::vector<Record> records;
+    std::vector<Slot> hash;
+
+    // Cold arrays, one entry per record
+    std::vector<std::uint32_t> defaults;
+    std::vector<std::uint32_t> helps;
+    std::vector<std::uint32_t> envs;
+    std::vector<std::uint32_t> choice_lists;
+    std::vector<std::uint32_t> choices;
+
+    // The empty string is always at offset zero
+    strings.add("");
+
+    for (const auto *args : {&optional, &required}) {
+        for (const auto &arg : *args) {
+            const std::size_t length = std::strlen(arg.long_opt);
+            if (length > MAX_NAME_LENGTH) return INVALID;
+
+            int action = actions::predefinedId(arg.action);
+            if (action < 0) {
+                if (custom_actions == nullptr) return UNSUPPORTED;
+                action = CUSTOM_ACTION + custom_actions->size();
+                custom_actions->emplace_back(arg.action);
+            }
+
+            if (arg.default_provider && custom_actions == nullptr)
+                return UNSUPPORTED;
+
+            const bool env = arg.env && *arg.env;
+            Record r = {
+                .long_opt = strings.add(arg.long_opt),
+                .long_opt_length = static_cast<std::uint16_t>(length),
+                .action = static_cast<std::uint16_t>(action),
+                .short_opt = arg.short_opt,
+                .flags = static_cast<std::uint8_t>(
+                    (arg.required ? FLAG_REQUIRED : 0) |
+                    (env ? FLAG_ENV : 0) |
+                    (arg.default_provider ? FLAG_COMPUTED : 0) |
+                    (static_cast<int>(arg.parameter_required)
+                     << FLAG_PARAMETER_SHIFT)),
+                .reserved = 0,
+            };
+            records.emplace_back(r);
+
+            defaults.push_back(strings.add(arg.default_value));
+            helps.push_back(strings.add(arg.help));
+            envs.push_back(strings.add(arg.env));
+            choice_lists.push_back(NONE);
+
+            if (arg.choices) {
+                const std::uint32_t list = choices.size();
+                choice_lists.back() = list;
+                choices.push_back(0);
+                for (auto choice = arg.choices; *choice; ++choice) {
+                    choices.push_back(strings.add(*choice));
+                    ++choices[list];
+                }
+            }
+        }
+    }
+
+    const std::uint32_t n_optional = optional.size();
+
+    // Open addressing, at most half full
+    std::uint32_t hash_slots = 1;
+    while (hash_slots < 2 * n_optional) hash_slots *= 2;
+
+    hash.assign(hash_slots, Slot{0, 0});
+    std::vector<std::uint32_t> shorts(256, 0);
+    std::vector<std::uint32_t> sorted(n_optional);
+
+    for (std::uint32_t i = 0; i < n_optional; ++i) {
+        const std::uint32_t h = hashName(optional[i].long_opt);
+        std::uint32_t slot = h & (hash_slots - 1);
+        while (hash[slot].record) slot = (slot + 1) & (hash_slots - 1);
+        hash[slot] = Slot{h, i + 1};
+
+        unsigned char c = records[i].short_opt;
+        if (c && !shorts[c]) shorts[c] = i + 1;
+
+        sorted[i] = i;
+    }
+
+    const std::string &pool = strings.data();
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&](std::uint32_t lhs, std::uint32_t rhs) {
+                         return std::strcmp(&pool[records[lhs].long_opt],
+                                            &pool[records[rhs].long_opt]) < 0;
+                     });
+
+    auto words = [](const std::vector<std::uint32_t> &v) {
+        return v.size() * sizeof(std::uint32_t);
+    };
+
+    // Sections in blob order
+    const std::uint32_t records_at = _align(sizeof(Header), alignof(Record));
+    const std::uint32_t hash_at = _align(
+        records_at + records.size() * sizeof(Record), alignof(Slot));
+    const std::uint32_t shorts_at = hash_at + hash.size() * sizeof(Slot);
+    const std::uint32_t sorted_at = shorts_at + words(shorts);
+    const std::uint32_t defaults_at = sorted_at + words(sorted);
+    const std::uint32_t helps_at = defaults_at + words(defaults);
+    const std::uint32_t envs_at = helps_at + words(helps);
+    const std::uint32_t choice_lists_at = envs_at + words(envs);
+    const std::uint32_t choices_at = choice_lists_at + words(choice_lists);
+    const std::uint32_t strings_at = choices_at + words(choices);
+
+    Header h = {
+        .magic = {},
+        .version = VERSION,
+        .byte_order = BYTE_ORDER_MARK,
+        .size = _align(strings_at + pool.size(), sizeof(std::uint64_t)),
+        // Computed once the blob is complete
+        .checksum = 0,
+        .n_optional = n_optional,
+        .n_required = static_cast<std::uint32_t>(required.size()),
+        .hash_slots = hash_slots,
+        .records = records_at,
+        .hash = hash_at,
+        .shorts = shorts_at,
+        .sorted = sorted_at,
+        .defaults = defaults_at,
+        .helps = helps_at,
+        .envs = envs_at,
+        .choice_lists = choice_lists_at,
+        .choices = choices_at,
+        .strings = strings_at,
+        .strings_size = static_cast<std::uint32_t>(pool.size()),
+    };
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+
+    out->assign(h.size / sizeof(std::uint64_t), 0);
+    char *base = reinterpret_cast<char *>(out->data());
+
+    auto put = [base](std::uint32_t at, const void *src, std::size_t size) {
+        if (size) std::memcpy(base + at, src, size);
+    };
+    put(h.records, records.data(), records.size() * sizeof(Record));
+    put(h.hash, hash.data(), hash.size() * sizeof(Slot));
+    put(h.shorts, shorts.data(), words(shorts));
+    put(h.sorted, sorted.data(), words(sorted));
+    put(h.defaults, defaults.data(), words(defaults));
+    put(h.helps, helps.data(), words(helps));
+    put(h.envs, envs.data(), words(envs));
+    put(h.choice_lists, choice_lists.data(), words(choice_lists));
+    put(h.choices, choices.data(), words(choices));
+    put(h.strings, pool.data(), pool.size());
+
+    put(0, &h, sizeof(Header));
+    h.checksum = _blob_checksum(base, h.size);
+    put(0, &h, sizeof(Header));
+    return OK;
+}
+
+static bool _within(std::uint64_t offset, std::uint64_t length,
+                    std::uint64_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+int check(const void *data, std::size_t size) {
+    if (data == nullptr || size < sizeof(Header) ||
+        reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t)) {
+        return INVALID;
+    }
+
+    const Header &h = *static_cast<const Header *>(data);
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) return INVALID;
+    if (h.byte_order != BYTE_ORDER_MARK) return UNSUPPORTED_VERSION;
+    if (h.version != VERSION) return UNSUPPORTED_VERSION;
+    if (h.size < sizeof(Header) || h.size > size) return INVALID;
+
+    const char *base = static_cast<const char *>(data);
+    if (_blob_checksum(base, h.size) != h.checksum) return CORRUPTED;
+
+    // The checksum matches, still never trust offsets blindly
+    const std::uint64_t n = std::uint64_t(h.n_optional) + h.n_required;
+    if (!_within(h.records, n * sizeof(Record), h.size) ||
+        !_within(h.hash, h.hash_slots * std::uint64_t(sizeof(Slot)),
+                 h.size) ||
+        !_within(h.shorts, 256 * 4ULL, h.size) ||
+        !_within(h.sorted, h.n_optional * 4ULL, h.size) ||
+        !_within(h.defaults, n * 4, h.size) ||
+        !_within(h.helps, n * 4, h.size) || !_within(h.envs, n * 4, h.size) ||
+        !_within(h.choice_lists, n * 4, h.size) ||
+        !_within(h.strings, h.strings_size, h.size) ||
+        h.records % alignof(Record) || h.hash % alignof(Slot) ||
+        h.shorts % 4 || h.sorted % 4 || h.defaults % 4 || h.helps % 4 ||
+        h.envs % 4 || h.choice_lists % 4 || h.choices % 4 ||
+        h.choices > h.strings || h.strings_size == 0 ||
+        base[h.strings + h.strings_size - 1] != '\0' || h.hash_slots == 0 ||
+        (h.hash_slots & (h.hash_slots - 1)) != 0) {
+        return INVALID;
+    }
+
+    View view{data};
+    const std::uint32_t n_choices = (h.strings - h.choices) / 4;
+    const auto *choices =
+        reinterpret_cast<const std::uint32_t *>(base + h.choices);
+    const auto *choice_lists =
+        reinterpret_cast<const std::uint32_t *>(base + h.choice_lists);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        const Record &r = view.record(i);
+        if (r.long_opt >= h.strings_size ||
+            r.long_opt + r.long_opt_length >= h.strings_size ||
+            actions::predefined(r.action) == nullptr ||
+            (r.flags & FLAG_COMPUTED)) {
+            return INVALID;
+        }
+
+        for (auto array : {h.defaults, h.helps, h.envs}) {
+            const auto *cold =
+                reinterpret_cast<const std::uint32_t *>(base + array);
+            if (cold[i] >= h.strings_size) return INVALID;
+        }
+
+        const std::uint32_t list = choice_lists[i];
+        if (list == NONE) continue;
+        if (list >= n_choices || choices[list] > n_choices - list - 1)
+            return INVALID;
+        for (std::uint32_t j = 1; j <= choices[list]; ++j) {
+            if (choices[list + j] >= h.strings_size) return INVALID;
+        }
+    }
+
+    // Lookups stop at the first empty slot, a full table never would
+    bool has_empty_slot = false;
+    for (std::uint32_t i = 0; i < h.hash_slots; ++i) {
+        const Slot &slot = reinterpret_cast<const Slot *>(base + h.hash)[i];
+        if (slot.record > h.n_optional) return INVALID;
+        if (slot.record == 0) has_empty_slot = true;
+    }
+    if (!has_empty_slot) return INVALID;
+
+    const auto *shorts =
+        reinterpret_cast<const std::uint32_t *>(base + h.shorts);
+    for (std::uint32_t c = 0; c < 256; ++c) {
+        if (shorts[c] > h.n_optional) return INVALID;
+    }
+
+    for (std::uint32_t i = 0; i < h.n_optional; ++i) {
+        if (view.sortedAt(i) >= h.n_optional) return INVALID;
+    }
+
+    return OK;
+}
+
+bool View::choices(std::uint32_t index,
+                   std::vector<const char *> *out) const {
+    out->clear();
+    const std::uint32_t list = _cold(_header->choice_lists, index);
+    if (list == NONE) return false;
+
+    const std::uint32_t *entries =
+        reinterpret_cast<const std::uint32_t *>(_base + _header->choices) +
+        list;
+    for (std::uint32_t i = 1; i <= entries[0]; ++i) {
+        out->push_back(string(entries[i]));
+    }
+    out->push_back(nullptr);
+    return true;
+}
+
+std::uint32_t View::findLong(std::string_view name) const {
+    const Slot *hash = reinterpret_cast<const Slot *>(_base + _header->hash);
+    const std::uint32_t mask = _header->hash_slots - 1;
+    const std::uint32_t h = hashName(name);
+
+    // Probing touches only the slots; a record (and its name) is read only
+    // when the full hash matches
+    for (std::uint32_t slot = h & mask; hash[slot].record;
+         slot = (slot + 1) & mask) {
+        if (hash[slot].hash != h) continue;
+
+        const std::uint32_t index = hash[slot].record - 1;
+        if (longOpt(record(index)) == name) return index;
+    }
+    return NONE;
+}
+
+std::uint32_t View::findShort(char c) const {
+    const std::uint32_t *shorts =
+        reinterpret_cast<const std::uint32_t *>(_base + _header->shorts);
+    return shorts[static_cast<unsigned char>(c)] - 1;
+}
+
+void View::findPrefix(std::string_view prefix, std::uint32_t *first,
+                      std::uint32_t *last) const {
+    std::uint32_t lo = 0;
+    std::uint32_t hi = _header->n_optional;
+
+    // First name not less than prefix
+    while (lo < hi) {
+        std::uint32_t mid = lo + (hi - lo) / 2;
+        if (longOpt(record(sortedAt(mid))) < prefix) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *first = lo;
+
+    // First name not starting with prefix
+    hi = _header->n_optional;
+    while (lo < hi) {
+        std::uint32_t mid = lo + (hi - lo) / 2;
+        if (longOpt(record(sortedAt(mid))).substr(0, prefix.size()) ==
+            prefix) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *last = lo;
+}
+
+}  // namespace cmdarg::schema
@@ -0,0 +1,281 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include <cmdarg/actions.hpp>
+#include <cmdarg/classify.hpp>
+#include <cmdarg/session.hpp>
+#include <cmdarg/session_state.hpp>
+
+namespace cmdarg {
+
+namespace session {
+
+// Runs the action of arg on value as a parse would, without keeping the
+// result; help requests are not errors
+static bool _accepts(const Argument &arg, std::string_view value) {
+    std::string dest = arg.default_value;
+    return arg.action(&dest, arg, std::string(value)) <= 0;
+}
+
+static void _fail(Option *option, ParseError::Kind kind, std::string token) {
+    option->error = kind;
+    option->error_token = std::move(token);
+}
+
+static void _analyse_long(const schema::View &schema,
+                          const std::vector<Argument> &optional,
+                          std::string_view token, Option *option) {
+    const std::size_t equal = token.find('=', 2);
+    const std::string_view name = token.substr(2, equal - 2);
+
+    std::uint32_t index = schema.findLong(name);
+    if (index == schema::NONE) {
+        std::uint32_t first;
+        std::uint32_t last;
+        schema.findPrefix(name, &first, &last);
+
+        if (last - first != 1) {
+            _fail(option,
+                  (last - first > 1) ? ParseError::Kind::AMBIGUOUS_OPTION
+                                     : ParseError::Kind::UNKNOWN_OPTION,
+                  "--" + std::string(name));
+            return;
+        }
+        index = schema.sortedAt(first);
+    }
+
+    const Argument &arg = optional[index];
+    const bool has_value = equal != std::string_view::npos;
+    const std::string_view value =
+        has_value ? token.substr(equal + 1) : std::string_view{};
+
+    switch (arg.parameter_required) {
+        case Argument::ParameterRequired::NO:
+            // --help=TERM searches the help
+            if (has_value && arg.action != actions::show_help_and_exit) {
+                _fail(option, ParseError::Kind::UNEXPECTED_PARAMETER,
+                      "--" + std::string(arg.long_opt));
+                return;
+            }
+            break;
+        case Argument::ParameterRequired::REQUIRED:
+            if (!has_value) {
+                option->takes_next = index;
+                return;
+            }
+            break;
+        case Argument::ParameterRequired::OPTIONAL:
+            break;
+    }
+
+    if (!_accepts(arg, value)) {
+        _fail(option, ParseError::Kind::INVALID_VALUE, std::string(value));
+    }
+}
+
+static void _analyse_short(const schema::View &schema,
+                           const std::vector<Argument> &optional,
+                           std::string_view token, Option *option) {
+    for (std::size_t c = 1; c < token.size(); ++c) {
+        const std::uint32_t index = schema.findShort(token[c]);
+        if (index == schema::NONE) {
+            _fail(option, ParseError::Kind::UNKNOWN_OPTION,
+                  std::string("-") + token[c]);
+            return;
+        }
+
+        const Argument &arg = optional[index];
+        const std::string_view rest = token.substr(c + 1);
+
+        if (arg.parameter_required == Argument::ParameterRequired::NO) {
+            if (!_accepts(arg, {})) {
+                _fail(option, ParseError::Kind::INVALID_VALUE, "");
+                return;
+            }
+            continue;
+        }
+
+        if (arg.parameter_required == Argument::ParameterRequired::REQUIRED &&
+            rest.empty()) {
+            option->takes_next = index;
+        } else if (!_accepts(arg, rest)) {
+            _fail(option, ParseError::Kind::INVALID_VALUE, std::string(rest));
+        }
+        return;
+    }
+}
+
+// Name of the option of token taking the next word, as parse reports it
+static std::string _option_name(const Token &token, const Argument &arg) {
+    if (token.kind == classify::SHORT) {
+        return std::string("-") + arg.short_opt;
+    }
+    return "--" + std::string(arg.long_opt);
+}
+
+void validate(const schema::View &schema,
+              const std::vector<Argument> &optional,
+              const std::vector<Argument> &required,
+              const HelpFormatter &formatter, State *state) {
+    // Arguments changed, nothing can be reused
+    if (state->schema != schema.header().checksum) {
+        for (auto &token : state->tokens) token.dirty = true;
+        state->schema = schema.header().checksum;
+    }
+
+    // Errors are reported to the caller instead
+    const bool quiet = actions::setQuiet(true);
+
+    const std::uint32_t n_optional = schema.optionalCount();
+    const std::uint32_t n_required = schema.requiredCount();
+    std::uint32_t req_option = 0;
+    bool options_done = false;
+
+    // Option whose value is the next word, and its position
+    std::uint32_t pending = NONE;
+    std::size_t pending_position = 0;
+
+    state->errors.clear();
+    auto report = [state](std::size_t position, ParseError::Kind kind,
+                          std::string token) {
+        TokenError error = {.position = position, .error = ParseError{}};
+        error.error.kind = kind;
+        error.error.token = std::move(token);
+        state->errors.emplace_back(std::move(error));
+    };
+
+    for (std::size_t i = 0; i < state->tokens.size(); ++i) {
+        Token &token = state->tokens[i];
+        if (token.dirty) {
+            token.kind = classify::kindOf(token.text);
+            token.option = Option{};
+            if (token.kind == classify::LONG) {
+                _analyse_long(schema, optional, token.text, &token.option);
+            } else if (token.kind == classify::SHORT) {
+                _analyse_short(schema, optional, token.text, &token.option);
+            }
+            token.value_record = NONE;
+            token.dirty = false;
+        }
+
+        // Values of options and positional arguments are converted again
+        // only when they are assigned to another argument
+        std::uint32_t record = NONE;
+        if (pending != NONE) {
+            record = pending;
+            pending = NONE;
+        } else if (options_done || token.kind == classify::POSITIONAL) {
+            if (req_option == n_required) {
+                report(i, ParseError::Kind::TOO_MANY_ARGUMENTS, token.text);
+                continue;
+            }
+            record = n_optional + req_option++;
+        } else if (token.kind == classify::END_OF_OPTIONS) {
+            options_done = true;
+            continue;
+        } else {
+            if (token.option.error != ParseError::Kind::NONE) {
+                report(i, token.option.error, token.option.error_token);
+            }
+            pending = token.option.takes_next;
+            pending_position = i;
+            continue;
+        }
+
+        if (token.value_record != record) {
+            const Argument &arg = (record < n_optional)
+                                      ? optional[record]
+                                      : required[record - n_optional];
+            token.value_record = record;
+            token.value_valid = _accepts(arg, token.text);
+        }
+        if (!token.value_valid) {
+            report(i, ParseError::Kind::INVALID_VALUE, token.text);
+        }
+    }
+
+    actions::setQuiet(quiet);
+
+    if (pending != NONE) {
+        report(pending_position, ParseError::Kind::MISSING_PARAMETER,
+               _option_name(state->tokens[pending_position],
+                            optional[pending]));
+    }
+
+    if (req_option < n_required) {
+        std::string missing = formatter.metavar(required[req_option]);
+        while (++req_option < n_required) {
+            missing += " " + formatter.metavar(required[req_option]);
+        }
+        report(state->tokens.size(), ParseError::Kind::MISSING_ARGUMENTS,
+               std::move(missing));
+    }
+}
+
+}  // namespace session
+
+Session::Session(Parser *parser)
+    : _parser(parser), _state(std::make_unique<session::State>()) {
+}
+
+Session::~Session() noexcept = default;
+
+void Session::assign(int count, const std::string_view tokens[]) {
+    _state->tokens.clear();
+    _state->tokens.resize(count);
+    for (int i = 0; i < count; ++i) {
+        _state->tokens[i].text = tokens[i];
+    }
+}
+
+int Session::insert(std::size_t index, std::string_view token) {
+    if (index > _state->tokens.size()) return -1;
+
+    session::Token inserted;
+    inserted.text = token;
+    _state->tokens.emplace(_state->tokens.begin() + index,
+                           std::move(inserted));
+    return 0;
+}
+
+int Session::remove(std::size_t index) {
+    if (index >= _state->tokens.size()) return -1;
+
+    _state->tokens.erase(_state->tokens.begin() + index);
+    return 0;
+}
+
+int Session::replace(std::size_t index, std::string_view token) {
+    if (index >= _state->tokens.size()) return -1;
+
+    session::Token &replaced = _state->tokens[index];
+    replaced.text = token;
+    replaced.dirty = true;
+    return 0;
+}
+
+std::size_t Session::size() const {
+    return _state->tokens.size();
+}
+
+std::string_view Session::token(std::size_t index) const {
+    return _state->tokens[index].text;
+}
+
+int Session::validate() {
+    return _parser->_validate(_state.get());
+}
+
+const std::vector<TokenError> &Session::errors() const {
+    return _state->errors;
+}
+
+}  // namespace cmdarg
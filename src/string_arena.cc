@@ -0,0 +1,93 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/schema.hpp>
+#include <cmdarg/string_arena.hpp>
+
+namespace cmdarg {
+
+void *StringArena::allocate(std::size_t size, std::size_t alignment) {
+    if (_chunks.size()) {
+        Chunk &chunk = _chunks.back();
+        const std::uintptr_t base =
+            reinterpret_cast<std::uintptr_t>(chunk.data.get());
+        const std::size_t offset =
+            ((base + _used + alignment - 1) & ~(alignment - 1)) - base;
+
+        if (offset <= chunk.size && size <= chunk.size - offset) {
+            _used = offset + size;
+            return chunk.data.get() + offset;
+        }
+    }
+
+    // Chunks are allocated with new, aligned for any fundamental type
+    std::size_t chunk_size =
+        _chunks.empty() ? FIRST_CHUNK_SIZE : 2 * _chunks.back().size;
+    chunk_size = std::max(chunk_size, size);
+
+    _chunks.push_back({std::make_unique<char[]>(chunk_size), chunk_size});
+    _used = size;
+    return _chunks.back().data.get();
+}
+
+void StringArena::_rehash(std::size_t n_slots) {
+    std::vector<Slot> slots(n_slots);
+    for (const auto &slot : _slots) {
+        if (slot.str == nullptr) continue;
+
+        std::size_t i = slot.hash & (n_slots - 1);
+        while (slots[i].str) i = (i + 1) & (n_slots - 1);
+        slots[i] = slot;
+    }
+    _slots.swap(slots);
+}
+
+const char *StringArena::intern(std::string_view s) {
+    if (2 * (_count + 1) > _slots.size()) {
+        _rehash(std::max<std::size_t>(64, 2 * _slots.size()));
+    }
+
+    const std::uint32_t hash = schema::hashName(s);
+    const std::size_t mask = _slots.size() - 1;
+
+    std::size_t i = hash & mask;
+    for (; _slots[i].str; i = (i + 1) & mask) {
+        const Slot &slot = _slots[i];
+        if (slot.hash == hash && std::string_view{slot.str, slot.length} == s)
+            return slot.str;
+    }
+
+    char *copy = static_cast<char *>(allocate(s.size() + 1, 1));
+    std::memcpy(copy, s.data(), s.size());
+    copy[s.size()] = '\0';
+
+    _slots[i] = {copy, static_cast<std::uint32_t>(s.size()), hash};
+    ++_count;
+    return copy;
+}
+
+const char *const *StringArena::internList(const char *const *list) {
+    if (list == nullptr) return nullptr;
+
+    std::size_t n = 0;
+    while (list[n]) ++n;
+
+    auto out = static_cast<const char **>(
+        allocate((n + 1) * sizeof(const char *), alignof(const char *)));
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = intern(list[i]);
+    }
+    out[n] = nullptr;
+    return out;
+}
+
+}  // namespace cmdarg
@@ -0,0 +1,311 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include <cmdarg/suggest.hpp>
+
+namespace cmdarg {
+
+// Bit-parallel edit distance (Myers, as reformulated by Hyyrö for the
+// Levenshtein distance) for patterns of up to 64 characters: one column of the
+// dynamic programming matrix is encoded as vertical deltas in two words and
+// updated with a handful of bitwise operations per text character.
+class MyersPattern {
+    std::uint64_t _peq[256] = {0};
+    std::uint64_t _last = 0;
+    int _length = 0;
+
+ public:
+    static constexpr int MAX_LENGTH = 64;
+
+    // One column of the matrix, after `column` characters of text
+    struct State {
+        std::uint64_t pv = ~0ULL;
+        std::uint64_t mv = 0;
+        int score;
+        int column = 0;
+    };
+
+    explicit MyersPattern(std::string_view pattern)
+        : _length(static_cast<int>(pattern.size())) {
+        for (int i = 0; i < _length; ++i) {
+            _peq[static_cast<unsigned char>(pattern[i])] |= 1ULL << i;
+        }
+        if (_length > 0) _last = 1ULL << (_length - 1);
+    }
+
+    inline State initial() const {
+        State out;
+        out.score = _length;
+        return out;
+    }
+
+    inline State step(const State &s, char c) const {
+        State out;
+        std::uint64_t eq = _peq[static_cast<unsigned char>(c)];
+        std::uint64_t xv = eq | s.mv;
+        std::uint64_t xh = (((eq & s.pv) + s.pv) ^ s.pv) | eq;
+        std::uint64_t ph = s.mv | ~(xh | s.pv);
+        std::uint64_t mh = s.pv & xh;
+
+        // With an empty pattern the distance is just the length of the text
+        out.score = (_length == 0) ? s.score + 1 : s.score;
+        if (ph & _last) {
+            ++out.score;
+        } else if (mh & _last) {
+            --out.score;
+        }
+
+        // The first row of the matrix grows by one at each column
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        out.pv = mh | ~(xv | ph);
+        out.mv = ph & xv;
+        out.column = s.column + 1;
+        return out;
+    }
+
+    // True if some cell of the column is within max_distance, i.e. if some
+    // extension of the text read so far may still match
+    inline bool viable(const State &s, int max_distance) const {
+        int v = s.column;
+        if (v <= max_distance) return true;
+
+        for (int i = 0; i < _length; ++i) {
+            v += static_cast<int>((s.pv >> i) & 1);
+            v -= static_cast<int>((s.mv >> i) & 1);
+            if (v <= max_distance) return true;
+        }
+        return false;
+    }
+
+    int distance(std::string_view text, int max_distance) const {
+        const int n = static_cast<int>(text.size());
+        if (_length == 0) return std::min(n, max_distance + 1);
+
+        State s = initial();
+        for (int j = 0; j < n; ++j) {
+            s = step(s, text[j]);
+
+            // The last row can decrease by at most one per remaining column
+            if (s.score - (n - j - 1) > max_distance) return max_distance + 1;
+        }
+
+        return std::min(s.score, max_distance + 1);
+    }
+};
+
+// Fallback for long strings: classic dynamic programming restricted to the
+// diagonal band of width 2 * max_distance + 1.
+static int _bandedDistance(std::string_view a, std::string_view b,
+                           int max_distance) {
+    const int m = static_cast<int>(a.size());
+    const int n = static_cast<int>(b.size());
+    const int inf = max_distance + 1;
+
+    std::vector<int> prev(n + 1, inf);
+    std::vector<int> curr(n + 1, inf);
+    for (int j = 0; j <= std::min(n, max_distance); ++j) prev[j] = j;
+
+    for (int i = 1; i <= m; ++i) {
+        int lo = std::max(1, i - max_distance);
+        int hi = std::min(n, i + max_distance);
+        int best = inf;
+
+        std::fill(curr.begin(), curr.end(), inf);
+        if (i <= max_distance) curr[0] = i;
+
+        for (int j = lo; j <= hi; ++j) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            int v =
+                std::min({prev[j - 1] + cost, prev[j] + 1, curr[j - 1] + 1});
+            curr[j] = std::min(v, inf);
+            best = std::min(best, curr[j]);
+        }
+
+        if (best > max_distance) return inf;
+        std::swap(prev, curr);
+    }
+
+    return std::min(prev[n], inf);
+}
+
+int editDistance(std::string_view a, std::string_view b, int max_distance) {
+    if (max_distance < 0) return 0;
+
+    int diff = static_cast<int>(a.size()) - static_cast<int>(b.size());
+    if (std::abs(diff) > max_distance) return max_distance + 1;
+
+    if (a.size() > b.size()) std::swap(a, b);
+    if (a.size() <= MyersPattern::MAX_LENGTH) {
+        return MyersPattern{a}.distance(b, max_distance);
+    }
+
+    return _bandedDistance(a, b, max_distance);
+}
+
+SuggestionIndex::SuggestionIndex(const char *const *names) {
+    if (!names) return;
+    for (; *names; ++names) {
+        add(*names);
+    }
+}
+
+void SuggestionIndex::add(std::string_view name) {
+    Entry e = {
+        .offset = static_cast<std::uint32_t>(_buffer.size()),
+        .length = static_cast<std::uint32_t>(name.size()),
+        .order = static_cast<std::uint32_t>(_entries.size()),
+    };
+    _buffer.append(name);
+    _entries.emplace_back(e);
+    _dirty = true;
+}
+
+void SuggestionIndex::clear() {
+    _buffer.clear();
+    _entries.clear();
+    _sorted.clear();
+    _lcp.clear();
+    _dirty = false;
+}
+
+void SuggestionIndex::_build() const {
+    auto name = [this](const Entry &e) {
+        return std::string_view{_buffer.data() + e.offset, e.length};
+    };
+
+    _sorted = _entries;
+    std::sort(_sorted.begin(), _sorted.end(),
+              [&name](const Entry &lhs, const Entry &rhs) {
+                  return name(lhs) < name(rhs);
+              });
+
+    _lcp.assign(_sorted.size(), 0);
+    for (std::size_t i = 1; i < _sorted.size(); ++i) {
+        std::string_view prev = name(_sorted[i - 1]);
+        std::string_view curr = name(_sorted[i]);
+        std::uint32_t l = 0;
+        while (l < prev.size() && l < curr.size() && prev[l] == curr[l]) ++l;
+        _lcp[i] = l;
+    }
+
+    _dirty = false;
+}
+
+std::vector<std::string> SuggestionIndex::suggest(
+    std::string_view query, int max_distance, std::size_t max_results) const {
+    if (_dirty) _build();
+
+    std::vector<std::string> out;
+    if (_sorted.empty() || max_results == 0) return out;
+
+    if (max_distance < 0) {
+        max_distance = std::clamp(static_cast<int>(query.size()) / 4, 2, 3);
+    }
+
+    struct Match {
+        int distance;
+        std::uint32_t order;
+        std::uint32_t index;
+    };
+    std::vector<Match> matches;
+
+    if (query.size() > MyersPattern::MAX_LENGTH) {
+        // Too long for a single machine word, plain scan
+        for (std::uint32_t i = 0; i < _sorted.size(); ++i) {
+            const Entry &e = _sorted[i];
+            std::string_view name{_buffer.data() + e.offset, e.length};
+            int d = editDistance(query, name, max_distance);
+            if (d <= max_distance) matches.push_back({d, e.order, i});
+        }
+    } else {
+        const MyersPattern pattern{query};
+
+        // states[d] is the column after the first d characters of the
+        // current name, the first `valid` are shared with the previous one
+        std::vector<MyersPattern::State> states{pattern.initial()};
+        std::uint32_t valid = 0;
+
+        std::uint32_t i = 0;
+        while (i < _sorted.size()) {
+            const Entry &e = _sorted[i];
+            const char *name = _buffer.data() + e.offset;
+
+            std::uint32_t d = std::min(valid, _lcp[i]);
+            if (states.size() < e.length + 1) states.resize(e.length + 1);
+
+            bool pruned = false;
+            for (; d < e.length; ++d) {
+                states[d + 1] = pattern.step(states[d], name[d]);
+                if (!pattern.viable(states[d + 1], max_distance)) {
+                    pruned = true;
+                    break;
+                }
+            }
+
+            if (pruned) {
+                // Skip every name sharing the first d + 1 characters: they
+                // are contiguous, so gallop forward and then bisect
+                std::string_view prefix{name, d + 1};
+                auto shares_prefix = [this, &prefix](const Entry &other) {
+                    std::string_view s{_buffer.data() + other.offset,
+                                       other.length};
+                    return s.substr(0, prefix.size()) == prefix;
+                };
+
+                std::size_t lo = i + 1;
+                std::size_t step = 1;
+                while (lo < _sorted.size() && _lcp[lo] > d) {
+                    std::size_t probe = std::min(lo + step, _sorted.size());
+                    if (probe < _sorted.size() &&
+                        shares_prefix(_sorted[probe])) {
+                        lo = probe + 1;
+                        step *= 2;
+                    } else {
+                        lo = std::partition_point(_sorted.begin() + lo,
+                                                  _sorted.begin() + probe,
+                                                  shares_prefix) -
+                             _sorted.begin();
+                        break;
+                    }
+                }
+
+                i = lo;
+                valid = d;
+                continue;
+            }
+
+            valid = e.length;
+            if (states[e.length].score <= max_distance) {
+                matches.push_back({states[e.length].score, e.order, i});
+            }
+            ++i;
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(),
+              [](const Match &lhs, const Match &rhs) {
+                  if (lhs.distance != rhs.distance)
+                      return lhs.distance < rhs.distance;
+                  return lhs.order < rhs.order;
+              });
+
+    for (const auto &m : matches) {
+        if (out.size() >= max_results) break;
+        const Entry &e = _sorted[m.index];
+        out.emplace_back(_buffer.data() + e.offset, e.length);
+    }
+
+    return out;
+}
+
+}  // namespace cmdarg
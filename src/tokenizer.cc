@@ -0,0 +1,159 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+// Project headers
+#include <cmdarg/tokenizer.hpp>
+
+namespace cmdarg {
+
+void *Arena::allocate(std::size_t size, std::size_t alignment) {
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(_data);
+    const std::uintptr_t next = (base + _used + alignment - 1) &
+                                ~static_cast<std::uintptr_t>(alignment - 1);
+    const std::size_t offset = next - base;
+
+    if (offset > _capacity || size > _capacity - offset) return nullptr;
+
+    _used = offset + size;
+    return _data + offset;
+}
+
+namespace tokenizer {
+
+static inline bool _is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+// Characters that keep their special meaning after a backslash within
+// double quotes
+static inline bool _is_escapable(char c) {
+    return c == '"' || c == '\\' || c == '$' || c == '`' || c == '\n';
+}
+
+// Scans the word starting at *pos, moving *pos past it and writing the
+// unquoted word to out, unless it is nullptr. Returns the length of the
+// unquoted word, or -1 if a quote is not closed; *plain tells whether the
+// word is the same once unquoted.
+static long _scan(std::string_view s, std::size_t *pos, char *out,
+                  bool *plain) {
+    std::size_t i = *pos;
+    long length = 0;
+    *plain = true;
+
+    auto put = [out, &length](char c) {
+        if (out) out[length] = c;
+        ++length;
+    };
+
+    while (i < s.size() && !_is_blank(s[i])) {
+        const char c = s[i];
+
+        if (c == '\\') {
+            *plain = false;
+            if (i + 1 == s.size()) return -1;
+            if (s[i + 1] != '\n') put(s[i + 1]);
+            i += 2;
+        } else if (c == '\'') {
+            *plain = false;
+            std::size_t close = s.find('\'', i + 1);
+            if (close == std::string_view::npos) return -1;
+            for (++i; i < close; ++i) put(s[i]);
+            ++i;
+        } else if (c == '"') {
+            *plain = false;
+            for (++i;; ++i) {
+                if (i == s.size()) return -1;
+                if (s[i] == '"') break;
+                if (s[i] == '\\' && i + 1 < s.size() &&
+                    _is_escapable(s[i + 1])) {
+                    if (s[++i] != '\n') put(s[i]);
+                } else {
+                    put(s[i]);
+                }
+            }
+            ++i;
+        } else {
+            put(c);
+            ++i;
+        }
+    }
+
+    *pos = i;
+    return length;
+}
+
+// Moves *pos to the start of the next word, skipping blanks, comments and
+// backslash-newline pairs (removed, as within words); returns false at the
+// end of s
+static bool _next_word(std::string_view s, std::size_t *pos) {
+    std::size_t i = *pos;
+    while (i < s.size()) {
+        if (_is_blank(s[i])) {
+            ++i;
+        } else if (s[i] == '\\' && i + 1 < s.size() && s[i + 1] == '\n') {
+            i += 2;
+        } else if (s[i] == '#') {
+            i = s.find('\n', i);
+            if (i == std::string_view::npos) i = s.size();
+        } else {
+            break;
+        }
+    }
+
+    *pos = i;
+    return i < s.size();
+}
+
+int split(std::string_view cmdline, Arena *arena,
+          const std::string_view **words, std::size_t *count) {
+    bool plain;
+
+    // Count first, so that the array of words is allocated once
+    std::size_t n = 0;
+    for (std::size_t pos = 0; _next_word(cmdline, &pos); ++n) {
+        if (_scan(cmdline, &pos, nullptr, &plain) < 0) return -1;
+    }
+
+    auto *out = static_cast<std::string_view *>(
+        arena->allocate(n * sizeof(std::string_view),
+                        alignof(std::string_view)));
+    if (out == nullptr) return -2;
+
+    std::size_t pos = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        _next_word(cmdline, &pos);
+
+        const std::size_t start = pos;
+        const long length = _scan(cmdline, &pos, nullptr, &plain);
+        if (plain) {
+            new (out + k) std::string_view(cmdline.substr(start, length));
+            continue;
+        }
+
+        char *buffer = static_cast<char *>(arena->allocate(length, 1));
+        if (buffer == nullptr) return -2;
+
+        std::size_t again = start;
+        _scan(cmdline, &again, buffer, &plain);
+        new (out + k) std::string_view(buffer, length);
+    }
+
+    *words = out;
+    *count = n;
+    return 0;
+}
+
+std::size_t scratchSize(std::size_t size) {
+    // Every word takes at least one character and one separator
+    return (size + 1) / 2 * sizeof(std::string_view) +
+           alignof(std::string_view) + size;
+}
+
+}  // namespace tokenizer
+
+}  // namespace cmdarg
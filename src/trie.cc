@@ -0,0 +1,121 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include <cmdarg/trie.hpp>
+
+namespace cmdarg {
+
+void Trie::build(std::vector<Entry> entries) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry &lhs, const Entry &rhs) {
+                         return lhs.first < rhs.first;
+                     });
+
+    clear();
+    _nodes.push_back(Node{.c = '\0'});
+
+    // Keys are inserted in order, so the only child that may be shared with
+    // the previous key is always the last one of its parent
+    std::vector<std::uint32_t> last_child{NONE};
+
+    for (const auto &entry : entries) {
+        std::uint32_t node = 0;
+
+        for (char c : entry.first) {
+            std::uint32_t last = last_child[node];
+            if (last != NONE && _nodes[last].c == c) {
+                node = last;
+                continue;
+            }
+
+            std::uint32_t added = _nodes.size();
+            _nodes.push_back(Node{.c = c});
+            last_child.push_back(NONE);
+
+            if (last == NONE) {
+                _nodes[node].first_child = added;
+            } else {
+                _nodes[last].next_sibling = added;
+            }
+            last_child[node] = added;
+            node = added;
+        }
+
+        if (_nodes[node].key < 0) {
+            _nodes[node].key = _entries.size();
+            _entries.emplace_back(entry);
+        }
+    }
+}
+
+void Trie::clear() {
+    _nodes.clear();
+    _entries.clear();
+}
+
+std::uint32_t Trie::_child(std::uint32_t node, char c) const {
+    // Siblings are in the order of the sorted keys, which compare bytes as
+    // unsigned (UTF-8 names come after ASCII ones)
+    const unsigned char key = c;
+    for (std::uint32_t child = _nodes[node].first_child; child != NONE;
+         child = _nodes[child].next_sibling) {
+        const unsigned char label = _nodes[child].c;
+        if (label == key) return child;
+        if (label > key) break;
+    }
+    return NONE;
+}
+
+int Trie::find(std::string_view key) const {
+    if (_nodes.empty()) return -1;
+
+    std::uint32_t node = 0;
+    for (char c : key) {
+        node = _child(node, c);
+        if (node == NONE) return -1;
+    }
+
+    std::int32_t index = _nodes[node].key;
+    return (index < 0) ? -1 : _entries[index].second;
+}
+
+void Trie::complete(std::string_view prefix,
+                    std::vector<std::string> *out) const {
+    if (_nodes.empty()) return;
+
+    std::uint32_t node = 0;
+    for (char c : prefix) {
+        node = _child(node, c);
+        if (node == NONE) return;
+    }
+
+    // Depth-first visit of the subtree, siblings in order
+    if (_nodes[node].key >= 0) {
+        out->emplace_back(_entries[_nodes[node].key].first);
+    }
+
+    std::vector<std::uint32_t> stack;
+    if (_nodes[node].first_child != NONE) {
+        stack.push_back(_nodes[node].first_child);
+    }
+
+    while (!stack.empty()) {
+        std::uint32_t current = stack.back();
+        stack.pop_back();
+
+        const Node &n = _nodes[current];
+        if (n.next_sibling != NONE) stack.push_back(n.next_sibling);
+        if (n.first_child != NONE) stack.push_back(n.first_child);
+        if (n.key >= 0) out->emplace_back(_entries[n.key].first);
+    }
+}
+
+}  // namespace cmdarg
@@ -0,0 +1,545 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Project headers
+#include <cmdarg.hpp>
+#include <cmdarg/classify.hpp>
+
+/*
+ * Micro-benchmarks of the hot paths of the library. Not a test: it is built
+ * with the tests but never run by ctest. Run it by hand on a quiet machine,
+ * in a release build, optionally with the name of one group to run only
+ * that one (e.g. "bench lookup"). Each line is the best time per operation
+ * over a few rounds.
+ */
+
+using cmdarg::Argument;
+
+// Results of the measured calls, so that they are not optimized away
+static volatile std::size_t _sink = 0;
+
+// Best time of one call of run(i), over a few rounds of ops calls, in ns
+template <typename Run>
+static double _time(std::size_t ops, Run run) {
+    double best = 0;
+    for (int round = 0; round < 5; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < ops; ++i) run(i);
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        const double per_op = elapsed.count() / ops;
+        if (round == 0 || per_op < best) best = per_op;
+    }
+    return best;
+}
+
+static void _report(const std::string &name, double ns) {
+    std::cout << std::left << std::setw(56) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns
+              << " ns" << std::endl;
+}
+
+// Reads per second of readers threads, each calling a read() of its own
+// from make() for a while, with one more thread calling write() in a loop
+// meanwhile if not empty
+template <typename Make>
+static double _throughput(int readers, Make make,
+                          const std::function<void()> &write) {
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> reads{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&]() {
+            auto read = make();
+            std::size_t count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                read();
+                ++count;
+            }
+            reads += count;
+        });
+    }
+    if (write) {
+        threads.emplace_back([&]() {
+            while (!done.load(std::memory_order_relaxed)) write();
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    done.store(true);
+    for (auto &thread : threads) thread.join();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return reads.load() / elapsed.count();
+}
+
+static void _report_rate(const std::string &name, double per_sec) {
+    std::cout << std::left << std::setw(56) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1)
+              << per_sec / 1e6 << " M/s" << std::endl;
+}
+
+// prefix0, prefix1, ... prefix<count - 1>
+static std::vector<std::string> _names(const std::string &prefix,
+                                       std::size_t count) {
+    std::vector<std::string> out;
+    for (std::size_t i = 0; i < count; ++i) {
+        out.push_back(prefix + std::to_string(i));
+    }
+    return out;
+}
+
+// Optional arguments with a required parameter, one per name
+static void _add_options(cmdarg::Parser *parser,
+                         const std::vector<std::string> &names) {
+    for (const auto &name : names) {
+        parser->addArgument({
+            .long_opt = name.c_str(),
+            .parameter_required = Argument::ParameterRequired::REQUIRED,
+        });
+    }
+}
+
+// Table of getopt_long for the options of _add_options, terminated by a
+// zeroed entry
+static std::vector<option> _getopt_table(
+    const std::vector<std::string> &names) {
+    std::vector<option> out;
+    for (const auto &name : names) {
+        out.push_back({name.c_str(), required_argument, nullptr, 0});
+    }
+    out.push_back({nullptr, 0, nullptr, 0});
+    return out;
+}
+
+// Index of name in table, compared in order as getopt_long does
+static std::size_t _scan(const std::vector<option> &table,
+                         const std::string &name) {
+    std::size_t i = 0;
+    for (; table[i].name; ++i) {
+        if (std::strcmp(table[i].name, name.c_str()) == 0) break;
+    }
+    return i;
+}
+
+static void benchLookup() {
+    for (std::size_t n : {64, 1000, 50000}) {
+        cmdarg::Parser parser{{.prog = "bench"}};
+        const std::vector<std::string> names = _names("option-", n);
+        const std::vector<std::string> missing = _names("missing-", n);
+        _add_options(&parser, names);
+        parser.argumentId(names[0]);
+
+        // The same names as an array of structs, for reference
+        const std::vector<option> table = _getopt_table(names);
+        const std::size_t scan_ops = std::max<std::size_t>((1 << 22) / n, 100);
+
+        // Names in an order that defeats the caches for large schemas
+        const std::string suffix = ", " + std::to_string(n) + " options";
+        _report("lookup: long option, hit" + suffix,
+                _time(1 << 20, [&](std::size_t i) {
+                    _sink = _sink + parser.argumentId(names[i * 7919 % n]);
+                }));
+        _report("lookup: scan of a getopt_long table, hit" + suffix,
+                _time(scan_ops, [&](std::size_t i) {
+                    _sink = _sink + _scan(table, names[i * 7919 % n]);
+                }));
+        _report("lookup: long option, miss" + suffix,
+                _time(1 << 20, [&](std::size_t i) {
+                    _sink = _sink + parser.argumentId(missing[i * 7919 % n]);
+                }));
+        _report("lookup: scan of a getopt_long table, miss" + suffix,
+                _time(scan_ops, [&](std::size_t i) {
+                    _sink = _sink + _scan(table, missing[i * 7919 % n]);
+                }));
+
+        // A whole parse, to put lookups in proportion
+        std::vector<std::string> words = {"bench"};
+        for (std::size_t i = 0; i < 64; ++i) {
+            words.push_back("--" + names[i * 7919 % n] + "=value");
+        }
+        const std::vector<std::string_view> argv{words.begin(), words.end()};
+        const std::size_t parse_ops = std::max<std::size_t>(100000 / n, 1);
+        _report("lookup: parse of 64 long options" + suffix,
+                _time(parse_ops, [&](std::size_t) {
+                    _sink = _sink + parser.parse(argv.size(), argv.data())
+                                        .size();
+                }));
+
+        // The same command line through getopt_long, which only finds the
+        // options (values are left in optarg)
+        std::vector<char *> c_argv;
+        for (auto &word : words) c_argv.push_back(word.data());
+        c_argv.push_back(nullptr);
+        opterr = 0;
+        _report("lookup: getopt_long of 64 long options" + suffix,
+                _time(parse_ops, [&](std::size_t) {
+                    int index = 0;
+                    optind = 0;
+                    while (getopt_long(c_argv.size() - 1, c_argv.data(), "",
+                                       table.data(), &index) != -1) {
+                        _sink = _sink + index;
+                    }
+                }));
+    }
+}
+
+static void benchClassify() {
+    for (std::size_t n : {1000000, 10000000}) {
+        // Half long options, half file names, in one buffer
+        std::string text;
+        std::vector<std::size_t> ends;
+        for (std::size_t i = 0; i < n; ++i) {
+            text += (i % 2) ? "file-" : "--id=";
+            text += std::to_string(i);
+            ends.push_back(text.size());
+        }
+        std::vector<std::string_view> tokens;
+        tokens.reserve(n);
+        for (std::size_t i = 0, start = 0; i < n; start = ends[i++]) {
+            tokens.emplace_back(text.data() + start, ends[i] - start);
+        }
+        const double count = n;
+        const std::string suffix =
+            ", " + std::to_string(n / 1000000) + "M tokens";
+
+        cmdarg::classify::Table table;
+        _report("classify: table only, per token" + suffix,
+                _time(1, [&](std::size_t) {
+                    cmdarg::classify::build(n, tokens.data(), &table);
+                }) / count);
+
+        cmdarg::Parser parser{{.prog = "bench"}};
+        parser.addArgument({
+            .long_opt = "id",
+            .parameter_required = Argument::ParameterRequired::REQUIRED,
+        });
+        parser.addArgument({.long_opt = "files", .required = true});
+        std::vector<std::string_view> argv = {"bench"};
+        for (std::size_t i = 0; i < n; i += 2) argv.push_back(tokens[i]);
+        argv.push_back("file");
+        _report("classify: parse of --id=N, per token" + suffix,
+                _time(1, [&](std::size_t) {
+                    _sink = _sink +
+                            parser.parse(argv.size(), argv.data()).size();
+                }) / (argv.size() - 1));
+    }
+}
+
+static void benchConfig() {
+    const char *path = "bench.ini";
+
+    for (std::size_t n : {100, 10000}) {
+        const std::vector<std::string> names = _names("option-", n);
+        {
+            std::ofstream file{path};
+            file << "# generated by bench\n";
+            for (const auto &name : names) {
+                file << name << " = \"value of " << name << "\"\n";
+            }
+        }
+
+        cmdarg::Parser parser{{.prog = "bench"}};
+        _add_options(&parser, names);
+        cmdarg::Parser plain{{.prog = "bench"}};
+        _add_options(&plain, names);
+
+        const std::string suffix = ", " + std::to_string(n) + " keys";
+        const std::size_t ops = std::max<std::size_t>(100000 / n, 1);
+        _report("config: loadConfig" + suffix, _time(ops, [&](std::size_t) {
+                    _sink = _sink + parser.loadConfig(path);
+                }));
+
+        // Every value comes from the file, or from the defaults
+        const std::string_view argv[] = {"bench"};
+        _report("config: parse, values from the file" + suffix,
+                _time(ops, [&](std::size_t) {
+                    _sink = _sink + parser.parse(1, argv).size();
+                }));
+        _report("config: parse, no file" + suffix,
+                _time(ops, [&](std::size_t) {
+                    _sink = _sink + plain.parse(1, argv).size();
+                }));
+    }
+
+    std::remove(path);
+}
+
+// Distinct command lines of 7 options each, over options
+static std::vector<std::vector<std::string>> _lines(
+    const std::vector<std::string> &options, std::size_t count) {
+    std::vector<std::vector<std::string>> lines;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::vector<std::string> line = {"bench"};
+        for (std::size_t j = 0; j < 7; ++j) {
+            line.push_back("--" + options[(i * 7 + j * 13) % options.size()]);
+            line.push_back(std::to_string(i));
+        }
+        lines.emplace_back(std::move(line));
+    }
+    return lines;
+}
+
+static void benchCache() {
+    cmdarg::Parser parser{{.prog = "bench"}};
+    _add_options(&parser, _names("option-", 42));
+    parser.setCacheCapacity(1 << 24);
+
+    const auto lines = _lines(_names("option-", 42), 300);
+    std::vector<std::vector<std::string_view>> argvs;
+    for (const auto &line : lines) argvs.emplace_back(line.begin(), line.end());
+
+    const std::size_t ops = 30000;
+    _report("cache: parse, 15 words", _time(ops, [&](std::size_t i) {
+                const auto &argv = argvs[i % argvs.size()];
+                _sink = _sink + parser.parse(argv.size(), argv.data()).size();
+            }));
+    _report("cache: parseCached, hit", _time(ops, [&](std::size_t i) {
+                const auto &argv = argvs[i % argvs.size()];
+                _sink = _sink +
+                        parser.parseCached(argv.size(), argv.data())->size();
+            }));
+
+    // Every call a miss: the parse, the key and the insertion
+    parser.setCacheCapacity(1);
+    _report("cache: parseCached, miss", _time(ops, [&](std::size_t i) {
+                const auto &argv = argvs[i % argvs.size()];
+                _sink = _sink +
+                        parser.parseCached(argv.size(), argv.data())->size();
+            }));
+}
+
+static void benchSession() {
+    cmdarg::Parser parser{{.prog = "bench"}};
+    const std::vector<std::string> options = _names("option-", 45);
+    _add_options(&parser, options);
+
+    // 200 words: 100 options, each followed by its value
+    std::vector<std::string> words;
+    for (std::size_t i = 0; i < 100; ++i) {
+        words.push_back("--" + options[i % options.size()]);
+        words.push_back("value-" + std::to_string(i));
+    }
+    const std::vector<std::string_view> line{words.begin(), words.end()};
+    std::vector<std::string_view> argv = {"bench"};
+    argv.insert(argv.end(), line.begin(), line.end());
+
+    cmdarg::Session session{&parser};
+    session.assign(line.size(), line.data());
+    session.validate();
+
+    const std::size_t ops = 100000;
+    _report("session: full parse, 200 words",
+            _time(ops / 10, [&](std::size_t) {
+                _sink = _sink + parser.parse(argv.size(), argv.data()).size();
+            }));
+
+    // Typing the last value, one character at a time
+    const std::string_view typed = "abcdefghijklmnopqrstuvwxyz";
+    _report("session: keystroke on the last word",
+            _time(ops, [&](std::size_t i) {
+                session.replace(line.size() - 1, typed.substr(0, i % 26 + 1));
+                _sink = _sink + session.validate();
+            }));
+
+    // An option with its value inserted and removed again mid-line
+    const std::size_t middle = line.size() / 2;
+    _report("session: insert or remove mid-line",
+            _time(ops, [&](std::size_t i) {
+                if (i % 2) {
+                    session.remove(middle);
+                } else {
+                    session.insert(middle, "--option-0=x");
+                }
+                _sink = _sink + session.validate();
+            }));
+}
+
+static void benchCompletion() {
+    for (std::size_t n : {100, 10000, 100000}) {
+        cmdarg::Parser parser{{.prog = "bench"}};
+        const std::vector<std::string> names = _names("option-", n);
+        _add_options(&parser, names);
+        const std::size_t ops = std::max<std::size_t>(1000000 / n, 10);
+
+        // The word being completed comes last, as the shell hands it over
+        for (std::string current :
+             {"--" + names[n * 3 / 4], std::string{"--option-1"},
+              std::string{"--opt"}}) {
+            char prog[] = "bench";
+            char *argv[] = {prog, current.data(), nullptr};
+            std::vector<std::string> candidates = parser.complete(2, argv);
+
+            const std::string suffix =
+                ", " + std::to_string(candidates.size()) + " of " +
+                std::to_string(n);
+            _report("completion: query" + suffix, _time(ops, [&](std::size_t) {
+                        _sink = _sink + parser.complete(2, argv).size();
+                    }));
+
+            // The same candidates from a scan of every name
+            const std::string_view prefix =
+                std::string_view{current}.substr(2);
+            _report("completion: linear scan" + suffix,
+                    _time(ops, [&](std::size_t) {
+                        candidates.clear();
+                        for (const auto &name : names) {
+                            if (name.compare(0, prefix.size(), prefix) == 0) {
+                                candidates.push_back("--" + name);
+                            }
+                        }
+                        _sink = _sink + candidates.size();
+                    }));
+        }
+    }
+}
+
+static void benchLive() {
+    cmdarg::Parser parser{{.prog = "bench"}};
+    _add_options(&parser, _names("option-", 10));
+
+    char prog[] = "bench";
+    char *argv[] = {prog, nullptr};
+    cmdarg::LiveOptions live{&parser, 1, argv};
+    cmdarg::LiveOptions::Reader reader{&live};
+
+    // Pinning a snapshot and reading one value, uncontended
+    const std::size_t ops = 1 << 22;
+    _report("live: read lock", _time(ops, [&](std::size_t) {
+                cmdarg::LiveOptions::ReadLock lock{&reader};
+                _sink = _sink + lock->size();
+            }));
+
+    cmdarg::Options values = parser.parse(1, argv);
+    std::shared_mutex mutex;
+    _report("live: std::shared_mutex, for reference",
+            _time(ops, [&](std::size_t) {
+                std::shared_lock lock{mutex};
+                _sink = _sink + values.size();
+            }));
+
+    _report("live: reload, no file", _time(1000, [&](std::size_t) {
+                _sink = _sink + live.reload();
+            }));
+
+    // Readers on all the cores, alone and with one more thread reloading in
+    // a loop (or replacing the values under the mutex)
+    const int readers =
+        std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    auto live_reader = [&]() {
+        auto own = std::make_unique<cmdarg::LiveOptions::Reader>(&live);
+        return [own = std::move(own)]() {
+            cmdarg::LiveOptions::ReadLock lock{own.get()};
+            _sink = _sink + lock->size();
+        };
+    };
+    auto mutex_reader = [&]() {
+        return [&]() {
+            std::shared_lock lock{mutex};
+            _sink = _sink + values.size();
+        };
+    };
+    auto reload = [&]() { _sink = _sink + live.reload(); };
+    auto replace = [&]() {
+        cmdarg::Options next = parser.parse(1, argv);
+        std::unique_lock lock{mutex};
+        values.swap(next);
+    };
+
+    const std::string threads = std::to_string(readers) + " readers";
+    _report_rate("live: reads, " + threads,
+                 _throughput(readers, live_reader, {}));
+    _report_rate("live: reads, " + threads + " and a reloader",
+                 _throughput(readers, live_reader, reload));
+    _report_rate("live: std::shared_mutex reads, " + threads,
+                 _throughput(readers, mutex_reader, {}));
+    _report_rate("live: std::shared_mutex reads, " + threads + " and a writer",
+                 _throughput(readers, mutex_reader, replace));
+}
+
+static void benchTokenizer() {
+    cmdarg::Parser parser{{.prog = "bench"}};
+    parser.addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_int,
+    });
+    parser.addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+    });
+    parser.addArgument({.long_opt = "file", .required = true});
+
+    const std::string_view cmdline = "-c 4 --name 'two words' input.txt";
+    const std::string_view argv[] = {"bench", "-c",        "4",
+                                     "--name", "two words", "input.txt"};
+    std::vector<char> buffer(cmdarg::tokenizer::scratchSize(cmdline.size()));
+    cmdarg::Arena arena{buffer.data(), buffer.size()};
+
+    const std::size_t ops = 1 << 20;
+    _report("tokenizer: split, 5 words", _time(ops, [&](std::size_t) {
+                const std::string_view *words;
+                std::size_t count;
+                arena.reset();
+                cmdarg::tokenizer::split(cmdline, &arena, &words, &count);
+                _sink = _sink + count;
+            }));
+    _report("tokenizer: parse of the command string",
+            _time(ops / 4, [&](std::size_t) {
+                arena.reset();
+                _sink = _sink + parser.parse(cmdline, &arena).size();
+            }));
+    _report("tokenizer: parse of the same words",
+            _time(ops / 4, [&](std::size_t) {
+                _sink = _sink + parser.parse(6, argv).size();
+            }));
+}
+
+int main(int argc, char *argv[]) {
+    const std::string_view only = (argc > 1) ? argv[1] : "";
+
+    struct Group {
+        std::string_view name;
+        void (*run)();
+    };
+    const Group groups[] = {
+        {"lookup", benchLookup},
+        {"classify", benchClassify},
+        {"config", benchConfig},
+        {"cache", benchCache},
+        {"session", benchSession},
+        {"completion", benchCompletion},
+        {"live", benchLive},
+        {"tokenizer", benchTokenizer},
+    };
+
+    for (const Group &group : groups) {
+        if (only.empty() || only == group.name) group.run();
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::bind;
+using cmdarg::ParseError;
+
+struct Config {
+    int port = 80;
+    double timeout = 1.5;
+    bool verbose = false;
+    std::string host = "localhost";
+    long level = 0;
+    std::uint8_t retries = 3;
+};
+
+struct Other {
+    int port = 0;
+};
+
+static std::string _log_file = "initial.log";
+
+static const Argument _options[] = {
+    {
+        .long_opt = "port",
+        .short_opt = 'p',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "8080",
+        .action = cmdarg::actions::store_positive_int,
+        .destination = bind<&Config::port>(),
+    },
+    {
+        .long_opt = "timeout",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_positive_double,
+        .destination = bind<&Config::timeout>(),
+    },
+    {
+        .long_opt = "verbose",
+        .action = cmdarg::actions::store_true,
+        .destination = bind<&Config::verbose>(),
+    },
+    {
+        .long_opt = "host",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .destination = bind<&Config::host>(),
+    },
+    {
+        .long_opt = "level",
+        .short_opt = 'l',
+        .default_value = "0",
+        .action = cmdarg::actions::increment_long,
+        .destination = bind<&Config::level>(),
+    },
+    {
+        .long_opt = "retries",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .destination = bind<&Config::retries>(),
+    },
+    {
+        .long_opt = "log",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "default.log",
+        .destination = bind(&_log_file),
+    },
+    // Not bound, parsed and checked all the same
+    {
+        .long_opt = "unbound",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_int,
+    },
+};
+
+static void testConvert() {
+    int i = 0;
+    CHECK_EQ(cmdarg::binding::convert("42", &i), 0);
+    CHECK_EQ(i, 42);
+    CHECK_EQ(cmdarg::binding::convert("+7", &i), 0);
+    CHECK_EQ(i, 7);
+    CHECK_EQ(cmdarg::binding::convert("-3", &i), 0);
+    CHECK_EQ(i, -3);
+    CHECK_EQ(cmdarg::binding::convert("+-3", &i), -1);
+    CHECK_EQ(cmdarg::binding::convert("4x", &i), -1);
+    CHECK_EQ(cmdarg::binding::convert("", &i), -1);
+    CHECK_EQ(cmdarg::binding::convert("99999999999", &i), -1);
+    CHECK_EQ(i, -3);
+
+    std::uint8_t small = 0;
+    CHECK_EQ(cmdarg::binding::convert("255", &small), 0);
+    CHECK_EQ(cmdarg::binding::convert("256", &small), -1);
+
+    double d = 0;
+    CHECK_EQ(cmdarg::binding::convert("2.5", &d), 0);
+    CHECK_EQ(d, 2.5);
+
+    bool b = false;
+    CHECK_EQ(cmdarg::binding::convert("true", &b), 0);
+    CHECK(b);
+    CHECK_EQ(cmdarg::binding::convert("yes", &b), -1);
+
+    std::string s;
+    CHECK_EQ(cmdarg::binding::convert("text", &s), 0);
+    CHECK_EQ(s, "text");
+}
+
+static void testParse() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    CHECK_EQ(parser.addArguments(_options, std::size(_options)), 0);
+
+    cmdarg::Binding<Config> binding{&parser};
+    Config config;
+
+    // Defaults, or the initializers of the struct for empty ones
+    const std::string_view empty[] = {"prog"};
+    CHECK_EQ(binding.parse(1, empty, &config), 0);
+    CHECK_EQ(config.port, 8080);
+    CHECK_EQ(config.timeout, 1.5);
+    CHECK(!config.verbose);
+    CHECK_EQ(config.host, "localhost");
+    CHECK_EQ(config.retries, 3);
+    CHECK_EQ(_log_file, "default.log");
+    CHECK_EQ(binding.defaults().port, 8080);
+
+    const std::string_view argv[] = {
+        "prog",    "-p",       "9000",    "--timeout=0.25", "--verbose",
+        "--host",  "example",  "-lll",    "--log=run.log",  "--retries=5",
+        "--port",  "9001",     "--unbound=1",
+    };
+    CHECK_EQ(binding.parse(13, argv, &config), 0);
+    CHECK_EQ(config.port, 9001);
+    CHECK_EQ(config.timeout, 0.25);
+    CHECK(config.verbose);
+    CHECK_EQ(config.host, "example");
+    CHECK_EQ(config.level, 3L);
+    CHECK_EQ(config.retries, 5);
+    CHECK_EQ(_log_file, "run.log");
+
+    // Every parse starts from the defaults again
+    CHECK_EQ(binding.parse(1, empty, &config), 0);
+    CHECK_EQ(config.port, 8080);
+    CHECK_EQ(config.level, 0L);
+    CHECK_EQ(config.host, "localhost");
+    CHECK_EQ(_log_file, "default.log");
+
+    // Invalid for the action, or for the field
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view invalid[] = {"prog", "--port=-1"};
+    CHECK_EQ(binding.parse(2, invalid, &config), -1);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+    const std::string_view unbound[] = {"prog", "--unbound=x"};
+    CHECK_EQ(binding.parse(2, unbound, &config), -1);
+    cmdarg::actions::setQuiet(quiet);
+
+    const std::string_view overflow[] = {"prog", "--retries=300"};
+    CHECK_EQ(binding.parse(2, overflow, &config), -1);
+    const std::string_view unknown[] = {"prog", "--bogus"};
+    CHECK_EQ(binding.parse(2, unknown, &config), -1);
+
+    // char *argv as well
+    char prog[] = "prog";
+    char host[] = "--host=raw";
+    char *raw[] = {prog, host, nullptr};
+    CHECK_EQ(binding.parse(2, raw, &config), 0);
+    CHECK_EQ(config.host, "raw");
+
+    // Not even the program name
+    char *none[] = {nullptr};
+    CHECK_EQ(binding.parse(0, none, &config), 0);
+    CHECK_EQ(config.host, "localhost");
+}
+
+static void testDefaults() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addArguments(_options, std::size(_options));
+
+    cmdarg::Binding<Config> binding{&parser};
+    Config config;
+    const std::string_view empty[] = {"prog"};
+    CHECK_EQ(binding.parse(1, empty, &config), 0);
+    CHECK_EQ(config.timeout, 1.5);
+
+    // Arguments added later refresh the default instance
+    static const Argument later[] = {
+        {
+            .long_opt = "wait",
+            .parameter_required = Argument::ParameterRequired::REQUIRED,
+            .default_value = "4.5",
+            .destination = bind<&Config::timeout>(),
+        },
+    };
+    CHECK_EQ(parser.addArguments(later, 1), 0);
+    CHECK_EQ(binding.parse(1, empty, &config), 0);
+    CHECK_EQ(config.timeout, 4.5);
+
+    // Defaults that do not fit their field
+    cmdarg::Parser broken{{.prog = "prog"}};
+    broken.addArgument({
+        .long_opt = "port",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "eighty",
+        .destination = bind<&Config::port>(),
+    });
+    cmdarg::Binding<Config> failing{&broken};
+    CHECK_EQ(failing.parse(1, empty, &config), -4);
+
+    // Members of another struct
+    cmdarg::Binding<Other> other{&parser};
+    Other out;
+    CHECK_EQ(other.parse(1, empty, &out), -3);
+}
+
+static void _setup(cmdarg::Parser * /*parser*/) {
+}
+
+static void testSubcommands() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addSubcommand({.name = "run", .setup = _setup});
+
+    cmdarg::Binding<Config> binding{&parser};
+    Config config;
+    const std::string_view argv[] = {"prog", "run"};
+    CHECK_EQ(binding.parse(2, argv, &config), -2);
+}
+
+int main() {
+    testConvert();
+    testParse();
+    testDefaults();
+    testSubcommands();
+    return test::result();
+}
@@ -0,0 +1,218 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "level",
+        .short_opt = 'l',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "0",
+        .action = cmdarg::actions::store_int,
+        .env = "CACHE_TEST_LEVEL",
+    });
+    parser->addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "anonymous",
+    });
+}
+
+static void testDisabled() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    // Every call parses again, nothing is counted
+    const std::string_view argv[] = {"prog", "-l", "3"};
+    auto first = parser.parseCached(3, argv);
+    auto second = parser.parseCached(3, argv);
+    CHECK(first != second);
+    CHECK_EQ(first->at("level"), "3");
+    CHECK_EQ(second->at("level"), "3");
+
+    const cmdarg::CacheStats stats = parser.cacheStats();
+    CHECK_EQ(stats.hits, 0U);
+    CHECK_EQ(stats.misses, 0U);
+    CHECK_EQ(stats.entries, 0U);
+}
+
+static void testHits() {
+    ::unsetenv("CACHE_TEST_LEVEL");
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    parser.setCacheCapacity(1 << 20);
+
+    const std::string_view argv[] = {"prog", "-l", "3", "--name=x"};
+    auto first = parser.parseCached(4, argv);
+    CHECK_EQ(first->at("level"), "3");
+    CHECK_EQ(first->at("name"), "x");
+
+    // Shared, whatever the program name
+    const std::string_view renamed[] = {"other", "-l", "3", "--name=x"};
+    CHECK(parser.parseCached(4, argv) == first);
+    CHECK(parser.parseCached(4, renamed) == first);
+
+    // Words are compared as a sequence, not joined
+    const std::string_view joined[] = {"prog", "-l3", "--name=x"};
+    auto other = parser.parseCached(3, joined);
+    CHECK(other != first);
+    CHECK_EQ(other->at("level"), "3");
+
+    cmdarg::CacheStats stats = parser.cacheStats();
+    CHECK_EQ(stats.hits, 2U);
+    CHECK_EQ(stats.misses, 2U);
+    CHECK_EQ(stats.entries, 2U);
+    CHECK(stats.bytes > 0);
+
+    // The environment of the arguments is part of the key
+    const std::string_view empty[] = {"prog"};
+    auto plain = parser.parseCached(1, empty);
+    CHECK_EQ(plain->at("level"), "0");
+    ::setenv("CACHE_TEST_LEVEL", "7", 1);
+    auto from_env = parser.parseCached(1, empty);
+    CHECK(from_env != plain);
+    CHECK_EQ(from_env->at("level"), "7");
+    CHECK(parser.parseCached(1, empty) == from_env);
+    ::unsetenv("CACHE_TEST_LEVEL");
+    CHECK(parser.parseCached(1, empty) == plain);
+
+    // char *argv as well
+    char prog[] = "prog";
+    char level[] = "-l";
+    char three[] = "3";
+    char name[] = "--name=x";
+    char *raw[] = {prog, level, three, name, nullptr};
+    CHECK(parser.parseCached(4, raw) == first);
+
+    // Not even the program name, the same as the program name alone
+    char *none[] = {nullptr};
+    CHECK(parser.parseCached(0, none) == plain);
+}
+
+static void testErrors() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    parser.setCacheCapacity(1 << 20);
+
+    // Failed parses are never cached
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view invalid[] = {"prog", "--level=x"};
+    parser.parseCached(2, invalid);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+    parser.parseCached(2, invalid);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK_EQ(parser.cacheStats().entries, 0U);
+    CHECK_EQ(parser.cacheStats().misses, 2U);
+
+    // A hit clears the error of the parse before it
+    const std::string_view argv[] = {"prog", "-l", "1"};
+    parser.parseCached(3, argv);
+    const std::string_view unknown[] = {"prog", "--bogus"};
+    parser.parseCached(2, unknown);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+    parser.parseCached(3, argv);
+    CHECK(!parser.lastError());
+    CHECK_EQ(parser.cacheStats().hits, 1U);
+}
+
+static void testInvalidation() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    parser.setCacheCapacity(1 << 20);
+
+    const std::string_view argv[] = {"prog", "-l", "1"};
+    auto first = parser.parseCached(3, argv);
+    CHECK_EQ(parser.cacheStats().entries, 1U);
+
+    // New arguments change the results, counters are kept
+    parser.addArgument({
+        .long_opt = "extra",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "e",
+    });
+    CHECK_EQ(parser.cacheStats().entries, 0U);
+    auto second = parser.parseCached(3, argv);
+    CHECK(second != first);
+    CHECK_EQ(second->at("extra"), "e");
+    CHECK_EQ(parser.cacheStats().misses, 2U);
+
+    // Disabling drops every entry
+    parser.setCacheCapacity(0);
+    CHECK_EQ(parser.cacheStats().entries, 0U);
+    CHECK_EQ(parser.cacheStats().bytes, 0U);
+}
+
+static void testEviction() {
+    constexpr int N = 200;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    parser.setCacheCapacity(1 << 20);
+
+    // Measure one entry, then keep room for a few
+    const std::string_view probe[] = {"prog", "--name=probe"};
+    parser.parseCached(2, probe);
+    const std::size_t entry = parser.cacheStats().bytes;
+    parser.setCacheCapacity(4 * entry + entry / 2);
+    CHECK_EQ(parser.cacheStats().entries, 1U);
+
+    std::vector<std::string> names;
+    for (int i = 0; i < N; ++i) names.push_back("--name=n" + std::to_string(i));
+
+    std::shared_ptr<const cmdarg::Options> kept;
+    for (int i = 0; i < N; ++i) {
+        const std::string_view argv[] = {"prog", names[i]};
+        auto result = parser.parseCached(2, argv);
+        CHECK(result != nullptr);
+        if (i == 0) kept = result;
+
+        // Used again, the first one is never the least recent
+        const std::string_view again[] = {"prog", names[0]};
+        CHECK(parser.parseCached(2, again) == kept);
+
+        const cmdarg::CacheStats stats = parser.cacheStats();
+        CHECK(stats.bytes <= 4 * entry + entry / 2);
+        CHECK(stats.entries <= 4U);
+    }
+
+    // Evicted ones are parsed again
+    const std::string_view old[] = {"prog", names[1]};
+    const std::uint64_t misses = parser.cacheStats().misses;
+    CHECK_EQ(parser.parseCached(2, old)->at("name"), "n1");
+    CHECK_EQ(parser.cacheStats().misses, misses + 1);
+
+    // Results alone larger than the capacity are not kept
+    parser.setCacheCapacity(entry / 2);
+    CHECK_EQ(parser.cacheStats().entries, 0U);
+    parser.parseCached(2, old);
+    CHECK_EQ(parser.cacheStats().entries, 0U);
+
+    // Results handed out outlive their entries
+    CHECK_EQ(kept->at("name"), "n0");
+}
+
+int main() {
+    testDisabled();
+    testHits();
+    testErrors();
+    testInvalidation();
+    testEviction();
+    return test::result();
+}
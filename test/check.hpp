@@ -0,0 +1,76 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// #pragma once
+#ifndef CMDARG_TEST_CHECK_H_
+#define CMDARG_TEST_CHECK_H_
+
+// System headers
+#include <cstdlib>
+#include <iostream>
+
+// Project headers
+#include <cmdarg.hpp>
+
+/*
+ * Checks of the behaviour tests: each test is a program that runs its checks
+ * and returns test::result(), non-zero if any of them failed; failures are
+ * printed on stderr and do not stop the test. Programs that terminate before
+ * test::result() (e.g. exiting on a help request) fail as well.
+ */
+
+namespace test {
+
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+inline bool &finished() {
+    static bool done = false;
+    return done;
+}
+
+inline void _check_finished() {
+    if (!finished()) {
+        std::cerr << "terminated before test::result()" << std::endl;
+        std::_Exit(1);
+    }
+}
+
+inline const int _registered = std::atexit(_check_finished);
+
+inline int result() {
+    finished() = true;
+    if (failures()) {
+        std::cerr << failures() << " check(s) failed" << std::endl;
+    }
+    return failures() != 0;
+}
+
+// Error handler that lets parse return, leaving the error in lastError()
+inline void keepError(const cmdarg::ParseError & /*err*/) {
+}
+
+}  // namespace test
+
+#define CHECK(cond)                                                       \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond \
+                      << ") failed" << std::endl;                         \
+            ++test::failures();                                           \
+        }                                                                 \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                    \
+    do {                                                                  \
+        if (!((a) == (b))) {                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #a \
+                      << ", " #b ") failed: " << (a) << " != " << (b)     \
+                      << std::endl;                                       \
+            ++test::failures();                                           \
+        }                                                                 \
+    } while (0)
+
+#endif  // CMDARG_TEST_CHECK_H_
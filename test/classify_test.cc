@@ -0,0 +1,200 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+// Keeps every value given, each one followed by a comma
+static int _append(std::string *dest, const Argument & /*opt*/,
+                   const std::string &src) {
+    dest->append(src);
+    dest->push_back(',');
+    return 0;
+}
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "id",
+        .short_opt = 'i',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = _append,
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .default_value = "0",
+        .action = cmdarg::actions::increment_int,
+    });
+    parser->addArgument({.long_opt = "first", .required = true});
+    parser->addArgument({.long_opt = "last", .required = true});
+}
+
+// Command line made of random options, with the expected results
+struct Line {
+    std::vector<std::string> tokens = {"prog"};
+    std::string ids;
+    int verbose = 0;
+};
+
+static std::uint32_t _random(std::uint32_t *state) {
+    *state = *state * 1664525U + 1013904223U;
+    return *state >> 8;
+}
+
+static Line _generate(std::size_t options, std::uint32_t seed) {
+    Line line;
+    auto &t = line.tokens;
+
+    // Positional arguments anywhere between options, the last one after
+    // "--"
+    const std::size_t first = _random(&seed) % (options + 1);
+
+    for (std::size_t i = 0; i < options; ++i) {
+        if (i == first) t.push_back("first");
+
+        // Values that look like options, or hold '=', as well
+        std::string value = std::to_string(i);
+        switch (_random(&seed) % 4) {
+            case 0:
+                value = "-" + value;
+                break;
+            case 1:
+                value = "a=" + value;
+                break;
+            default:
+                break;
+        }
+
+        switch (_random(&seed) % 10) {
+            case 0:
+                t.push_back("--id=" + value);
+                break;
+            case 1:
+                t.insert(t.end(), {"--id", value});
+                break;
+            case 2:
+                t.push_back("-i" + value);
+                break;
+            case 3:
+                t.insert(t.end(), {"-i", value});
+                break;
+            case 4:
+                t.insert(t.end(), {"-i", "--"});
+                value = "--";
+                break;
+            case 5:
+                t.insert(t.end(), {"--id", "-"});
+                value = "-";
+                break;
+            case 6:
+                t.push_back("--id=");
+                value = "";
+                break;
+            case 7:
+                t.push_back("-v");
+                ++line.verbose;
+                continue;
+            case 8:
+                t.push_back("--verbose");
+                ++line.verbose;
+                continue;
+            default:
+                t.push_back("-vvi" + value);
+                line.verbose += 2;
+                break;
+        }
+        line.ids += value + ",";
+    }
+
+    if (first == options) t.push_back("first");
+    t.insert(t.end(), {"--", "--last"});
+    return line;
+}
+
+static void _check(cmdarg::Parser *parser, const Line &line) {
+    const std::vector<std::string_view> argv{line.tokens.begin(),
+                                             line.tokens.end()};
+    auto values = parser->parse(argv.size(), argv.data());
+    CHECK(!parser->lastError());
+    CHECK_EQ(values.at("id"), line.ids);
+    CHECK_EQ(values.at("verbose"), std::to_string(line.verbose));
+    CHECK_EQ(values.at("first"), "first");
+    CHECK_EQ(values.at("last"), "--last");
+}
+
+static void testShort() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // Every length of short command lines
+    for (std::size_t options = 0; options < 40; ++options) {
+        _check(&parser, _generate(options, options));
+    }
+}
+
+static void testLong() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // Spanning more than one classification window, with options and their
+    // values split across them
+    for (std::uint32_t seed = 1; seed <= 8; ++seed) {
+        _check(&parser, _generate(6000 + seed * 37, seed));
+    }
+
+    // An option missing its value at the very end, in place of "--"
+    Line line = _generate(5000, 99);
+    line.tokens.resize(line.tokens.size() - 2);
+    line.tokens.push_back("--id");
+    const std::vector<std::string_view> argv{line.tokens.begin(),
+                                             line.tokens.end()};
+    parser.parse(argv.size(), argv.data());
+    CHECK(parser.lastError().kind ==
+          cmdarg::ParseError::Kind::MISSING_PARAMETER);
+}
+
+static void testArgv() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // char *argv of shrinking lengths, viewed a window at a time (the
+    // longest ones with options and their values split across windows)
+    for (std::size_t options : {9000, 6037, 3000, 20, 0}) {
+        Line line = _generate(options, options + 1);
+        std::vector<char *> argv;
+        for (auto &word : line.tokens) argv.push_back(word.data());
+        argv.push_back(nullptr);
+
+        auto values = parser.parse(argv.size() - 1, argv.data());
+        CHECK(!parser.lastError());
+        CHECK_EQ(values.at("id"), line.ids);
+        CHECK_EQ(values.at("verbose"), std::to_string(line.verbose));
+    }
+
+    // Not even the program name
+    char *none[] = {nullptr};
+    parser.parse(0, none);
+    CHECK(parser.lastError().kind ==
+          cmdarg::ParseError::Kind::MISSING_ARGUMENTS);
+    parser.parse(0, static_cast<const std::string_view *>(nullptr));
+    CHECK(parser.lastError().kind ==
+          cmdarg::ParseError::Kind::MISSING_ARGUMENTS);
+}
+
+int main() {
+    testShort();
+    testLong();
+    testArgv();
+    return test::result();
+}
@@ -0,0 +1,115 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+using Words = std::vector<std::string>;
+
+// Candidates for the last of words (which follow the program name), sorted
+static Words _complete(cmdarg::Parser *parser,
+                       std::initializer_list<std::string> words) {
+    Words storage{"prog"};
+    storage.insert(storage.end(), words);
+
+    std::vector<char *> argv;
+    for (auto &word : storage) argv.push_back(word.data());
+
+    Words out = parser->complete(argv.size(), argv.data());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static void _setup_run(cmdarg::Parser *parser) {
+    parser->addArgument({.long_opt = "fast"});
+    parser->addArgument({.long_opt = "force"});
+}
+
+static void testOptions() {
+    static const char *const levels[] = {"debug", "info", "déjà", nullptr};
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addArgument({.long_opt = "verbose", .short_opt = 'v'});
+    parser.addArgument({.long_opt = "version"});
+    parser.addArgument({
+        .long_opt = "level",
+        .short_opt = 'l',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_choice,
+        .choices = levels,
+    });
+
+    CHECK((_complete(&parser, {"--ver"}) == Words{"--verbose", "--version"}));
+    CHECK((_complete(&parser, {"--verb"}) == Words{"--verbose"}));
+    CHECK(_complete(&parser, {"--x"}).empty());
+
+    // Every option, short ones and --help included
+    CHECK_EQ(_complete(&parser, {"-"}).size(), 7U);
+
+    // Values of choices, after '=' or as the next word
+    CHECK((_complete(&parser, {"--level=d"}) ==
+           Words{"--level=debug", "--level=déjà"}));
+    CHECK((_complete(&parser, {"--level", "i"}) == Words{"info"}));
+    CHECK((_complete(&parser, {"-l", "i"}) == Words{"info"}));
+    CHECK((_complete(&parser, {"-vl", ""}) == Words{"debug", "déjà", "info"}));
+
+    // Labels beyond ASCII
+    CHECK((_complete(&parser, {"--level=dé"}) == Words{"--level=déjà"}));
+
+    // After "--" words are not options
+    CHECK(_complete(&parser, {"--", "--ver"}).empty());
+
+    // Adding arguments rebuilds the candidates
+    parser.addArgument({.long_opt = "verify"});
+    CHECK_EQ(_complete(&parser, {"--ver"}).size(), 3U);
+}
+
+static void testSubcommands() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addArgument({.long_opt = "quiet"});
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+    parser.addSubcommand({.name = "remove", .setup = _setup_run});
+    parser.addSubcommand({.name = "list", .setup = _setup_run});
+
+    CHECK((_complete(&parser, {"r"}) == Words{"remove", "run"}));
+    CHECK((_complete(&parser, {""}) == Words{"list", "remove", "run"}));
+    CHECK((_complete(&parser, {"--q"}) == Words{"--quiet"}));
+
+    // The selected subcommand completes the rest
+    CHECK((_complete(&parser, {"run", "--f"}) == Words{"--fast", "--force"}));
+    CHECK(_complete(&parser, {"nope", "--f"}).empty());
+}
+
+static void testScripts() {
+    cmdarg::completion::Shell shell;
+    CHECK(cmdarg::completion::shellFromName("bash", &shell));
+    CHECK(shell == cmdarg::completion::Shell::BASH);
+    CHECK(cmdarg::completion::shellFromName("zsh", &shell));
+    CHECK(shell == cmdarg::completion::Shell::ZSH);
+    CHECK(cmdarg::completion::shellFromName("fish", &shell));
+    CHECK(shell == cmdarg::completion::Shell::FISH);
+    CHECK(!cmdarg::completion::shellFromName("csh", &shell));
+
+    for (auto kind : {cmdarg::completion::Shell::BASH,
+                      cmdarg::completion::Shell::ZSH,
+                      cmdarg::completion::Shell::FISH}) {
+        const std::string script = cmdarg::completion::script(kind, "prog");
+        CHECK(script.find("prog") != std::string::npos);
+        CHECK(script.find(cmdarg::completion::REQUEST) != std::string::npos);
+    }
+}
+
+int main() {
+    testOptions();
+    testSubcommands();
+    testScripts();
+    return test::result();
+}
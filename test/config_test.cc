@@ -0,0 +1,186 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::Source;
+
+static const char *const _COLORS[] = {"red", "green", nullptr};
+
+static void _write(const char *path, const char *content) {
+    std::ofstream file{path};
+    file << content;
+}
+
+static void _setup_build(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "jobs",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "1",
+        .action = cmdarg::actions::store_positive_int,
+    });
+}
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "5",
+        .action = cmdarg::actions::store_positive_int,
+        .env = "CONFIG_TEST_COUNT",
+    });
+    parser->addArgument({
+        .long_opt = "color",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "red",
+        .action = cmdarg::actions::store_choice,
+        .choices = _COLORS,
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .action = cmdarg::actions::store_true,
+        .env = "CONFIG_TEST_VERBOSE",
+    });
+    parser->addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+    });
+}
+
+static void testPrecedence() {
+    const char *path = "config_test.ini";
+    _write(path,
+           "# top level\n"
+           "count = 7\n"
+           "color = green  # comment\n"
+           "name = 'a # b'\n"
+           "unknown = \"not even read\n");
+
+    ::unsetenv("CONFIG_TEST_COUNT");
+    ::unsetenv("CONFIG_TEST_VERBOSE");
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    CHECK_EQ(parser.loadConfig(path), 0);
+
+    const std::string_view empty[] = {"prog"};
+    auto values = parser.parse(1, empty);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values["count"], "7");
+    CHECK(parser.source("count") == Source::CONFIG_FILE);
+    CHECK_EQ(values["color"], "green");
+    CHECK_EQ(values["name"], "a # b");
+    CHECK_EQ(values["verbose"], "");
+    CHECK(parser.source("verbose") == Source::DEFAULT);
+
+    // The environment beats the file
+    ::setenv("CONFIG_TEST_COUNT", "9", 1);
+    ::setenv("CONFIG_TEST_VERBOSE", "Yes", 1);
+    values = parser.parse(1, empty);
+    CHECK_EQ(values["count"], "9");
+    CHECK(parser.source("count") == Source::ENVIRONMENT);
+    CHECK_EQ(values["verbose"], "true");
+    CHECK(parser.source("verbose") == Source::ENVIRONMENT);
+
+    // ... and the command line beats both
+    const std::string_view argv[] = {"prog", "-c", "3", "--color", "red"};
+    values = parser.parse(5, argv);
+    CHECK_EQ(values["count"], "3");
+    CHECK(parser.source("count") == Source::COMMAND_LINE);
+    CHECK_EQ(values["color"], "red");
+    CHECK(parser.source("color") == Source::COMMAND_LINE);
+    CHECK_EQ(values["name"], "a # b");
+
+    // Values of every layer go through the actions
+    ::setenv("CONFIG_TEST_COUNT", "-1", 1);
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    parser.parse(1, empty);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == cmdarg::ParseError::Kind::INVALID_VALUE);
+
+    ::unsetenv("CONFIG_TEST_COUNT");
+    ::unsetenv("CONFIG_TEST_VERBOSE");
+
+    // Reloads pick up changes to the file
+    _write(path, "count = 11\ncount = 12\n");
+    CHECK_EQ(parser.reloadConfig(), 0);
+    values = parser.parse(1, empty);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values["count"], "12");
+    CHECK_EQ(values["color"], "red");
+    CHECK(parser.source("color") == Source::DEFAULT);
+
+    std::remove(path);
+}
+
+static void testSections() {
+    const char *path = "config_test_sections.ini";
+    _write(path,
+           "count = 2\n"
+           "[build]\n"
+           "jobs = 8\n"
+           "[other]\n"
+           "count = 99\n");
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    parser.addSubcommand({.name = "build", .setup = _setup_build});
+    CHECK_EQ(parser.loadConfig(path), 0);
+
+    const std::string_view argv[] = {"prog", "build"};
+    auto values = parser.parse(2, argv);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values["count"], "2");
+    CHECK_EQ(values["jobs"], "8");
+    CHECK(parser.source("jobs") == Source::CONFIG_FILE);
+
+    cmdarg::Parser other{{.prog = "prog"}};
+    _add_arguments(&other);
+    CHECK_EQ(other.loadConfig(path, "other"), 0);
+    const std::string_view empty[] = {"prog"};
+    CHECK_EQ(other.parse(1, empty)["count"], "99");
+
+    std::remove(path);
+}
+
+static void testMalformed() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    CHECK_EQ(parser.loadConfig("config_test.missing"), -1);
+
+    const char *path = "config_test_bad.ini";
+    _write(path, "count = 1\n\nbad line\n");
+    CHECK_EQ(parser.loadConfig(path), 3);
+
+    _write(path, "[unterminated\n");
+    CHECK_EQ(parser.loadConfig(path), 1);
+
+    _write(path, "count = 1\nname = \"open\n");
+    CHECK_EQ(parser.loadConfig(path), 2);
+
+    _write(path, "");
+    CHECK_EQ(parser.loadConfig(path), 0);
+
+    std::remove(path);
+}
+
+int main() {
+    testPrecedence();
+    testSections();
+    testMalformed();
+    return test::result();
+}
@@ -0,0 +1,214 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "5",
+        .action = cmdarg::actions::store_int,
+    });
+    parser->addArgument({
+        .long_opt = "color",
+        .parameter_required = Argument::ParameterRequired::OPTIONAL,
+        .default_value = "auto",
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .default_value = "0",
+        .action = cmdarg::actions::increment_int,
+    });
+    parser->addArgument({
+        .long_opt = "quiet",
+        .short_opt = 'q',
+        .action = cmdarg::actions::store_true,
+    });
+    parser->addArgument({
+        .long_opt = "level",
+        .short_opt = 'l',
+        .parameter_required = Argument::ParameterRequired::OPTIONAL,
+        .default_value = "none",
+    });
+    parser->addArgument({.long_opt = "input", .required = true});
+    parser->addArgument({.long_opt = "output", .required = true});
+}
+
+template <std::size_t N>
+static cmdarg::Options _parse(cmdarg::Parser *parser,
+                              const std::string_view (&argv)[N]) {
+    return parser->parse(N, argv);
+}
+
+static void testLong() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    const std::string_view given[] = {"prog", "--count", "7", "in",
+                                      "--color=never", "out", "--quiet"};
+    auto values = _parse(&parser, given);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("count"), "7");
+    CHECK_EQ(values.at("color"), "never");
+    CHECK_EQ(values.at("quiet"), "true");
+    CHECK_EQ(values.at("input"), "in");
+    CHECK_EQ(values.at("output"), "out");
+
+    // Unambiguous prefixes, optional parameters left out
+    const std::string_view prefix[] = {"prog", "--cou=8", "--col", "--v",
+                                       "in", "out"};
+    values = _parse(&parser, prefix);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("count"), "8");
+    CHECK_EQ(values.at("color"), "");
+    CHECK_EQ(values.at("verbose"), "1");
+
+    const std::string_view ambiguous[] = {"prog", "--co=1", "in", "out"};
+    _parse(&parser, ambiguous);
+    CHECK(parser.lastError().kind == ParseError::Kind::AMBIGUOUS_OPTION);
+    CHECK_EQ(parser.lastError().token, "--co");
+    CHECK(parser.lastError().suggestions ==
+          (std::vector<std::string>{"--color", "--count"}));
+
+    const std::string_view unknown[] = {"prog", "--size", "in", "out"};
+    _parse(&parser, unknown);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+    CHECK_EQ(parser.lastError().token, "--size");
+
+    const std::string_view missing[] = {"prog", "in", "out", "--count"};
+    _parse(&parser, missing);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_PARAMETER);
+    CHECK_EQ(parser.lastError().token, "--count");
+
+    const std::string_view unexpected[] = {"prog", "--quiet=yes", "in", "out"};
+    _parse(&parser, unexpected);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNEXPECTED_PARAMETER);
+    CHECK_EQ(parser.lastError().token, "--quiet");
+}
+
+static void testShort() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // Clusters, the first option with a parameter takes the rest
+    const std::string_view cluster[] = {"prog", "-vvqc12", "in", "out"};
+    auto values = _parse(&parser, cluster);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("verbose"), "2");
+    CHECK_EQ(values.at("quiet"), "true");
+    CHECK_EQ(values.at("count"), "12");
+
+    const std::string_view separate[] = {"prog", "-c", "3", "-lhigh",
+                                         "in", "-l", "out"};
+    values = _parse(&parser, separate);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("count"), "3");
+    CHECK_EQ(values.at("level"), "");
+    CHECK_EQ(values.at("output"), "out");
+
+    const std::string_view unknown[] = {"prog", "-vx", "in", "out"};
+    _parse(&parser, unknown);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+    CHECK_EQ(parser.lastError().token, "-x");
+
+    const std::string_view missing[] = {"prog", "in", "out", "-vc"};
+    _parse(&parser, missing);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_PARAMETER);
+    CHECK_EQ(parser.lastError().token, "-c");
+
+    const std::string_view invalid[] = {"prog", "-c", "many", "in", "out"};
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    _parse(&parser, invalid);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+}
+
+static void testPositional() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // "-" is positional, everything after "--" as well
+    const std::string_view dashes[] = {"prog", "-", "--", "--count"};
+    auto values = _parse(&parser, dashes);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("input"), "-");
+    CHECK_EQ(values.at("output"), "--count");
+    CHECK_EQ(values.at("count"), "5");
+
+    const std::string_view extra[] = {"prog", "a", "b", "c", "d"};
+    _parse(&parser, extra);
+    CHECK(parser.lastError().kind == ParseError::Kind::TOO_MANY_ARGUMENTS);
+    CHECK_EQ(parser.lastError().token, "c d");
+
+    const std::string_view few[] = {"prog", "-q"};
+    _parse(&parser, few);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_ARGUMENTS);
+    CHECK_EQ(parser.lastError().token, "INPUT OUTPUT");
+}
+
+static void testReset() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    const std::string_view first[] = {"prog", "-vvv", "-c", "1", "in", "out"};
+    auto values = _parse(&parser, first);
+    CHECK_EQ(values.at("verbose"), "3");
+
+    // Nothing leaks from a parse to the next one
+    const std::string_view second[] = {"prog", "-v", "in2", "out2"};
+    values = _parse(&parser, second);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("verbose"), "1");
+    CHECK_EQ(values.at("count"), "5");
+    CHECK_EQ(values.at("input"), "in2");
+
+    std::string value;
+    CHECK_EQ(parser.value("verbose", &value), 0);
+    CHECK_EQ(value, "1");
+    CHECK_EQ(parser.value("output", &value), 0);
+    CHECK_EQ(value, "out2");
+    CHECK(parser.value("missing", &value) != 0);
+
+    // Failed parses leave no values behind either
+    const std::string_view failing[] = {"prog", "-vv", "--bogus"};
+    _parse(&parser, failing);
+    CHECK(parser.lastError());
+    values = _parse(&parser, second);
+    CHECK_EQ(values.at("verbose"), "1");
+
+    parser.clear();
+    CHECK_EQ(parser.value("verbose", &value), 0);
+    CHECK_EQ(value, "0");
+
+    // Arguments added later are dispatched as well
+    parser.addArgument({.long_opt = "added", .short_opt = 'a'});
+    const std::string_view added[] = {"prog", "-a", "in", "out"};
+    values = _parse(&parser, added);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.count("added"), 1U);
+    CHECK_EQ(values.at("verbose"), "0");
+}
+
+int main() {
+    testLong();
+    testShort();
+    testPositional();
+    testReset();
+    return test::result();
+}
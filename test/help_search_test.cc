@@ -0,0 +1,130 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "color",
+        .help = "Colorize the output",
+    });
+    parser->addArgument({
+        .long_opt = "colormap",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Map of colors to use",
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .help = "Print more output",
+    });
+    parser->addArgument({
+        .long_opt = "output",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Where to write",
+    });
+    parser->addArgument({
+        .long_opt = "log-level",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Verbosity of the log, 0-3",
+    });
+    parser->addArgument({
+        .long_opt = "input",
+        .required = true,
+        .help = "File to read",
+    });
+}
+
+// Names of the options listed in text, in order
+static std::vector<std::string> _listed(const std::string &text) {
+    std::vector<std::string> out;
+    for (std::size_t at = text.find("--"); at != std::string::npos;
+         at = text.find("--", at)) {
+        const std::size_t end = text.find_first_of(" \n", at);
+        out.push_back(text.substr(at + 2, end - at - 2));
+        at = end;
+    }
+    return out;
+}
+
+using Names = std::vector<std::string>;
+
+static void testRanking() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    // Names starting with the term, in registration order
+    CHECK(_listed(parser.searchHelp("col")) == (Names{"color", "colormap"}));
+
+    // The whole name, then help words, exact ones before prefixes
+    CHECK(_listed(parser.searchHelp("output")) ==
+          (Names{"output", "color", "verbose"}));
+    CHECK(_listed(parser.searchHelp("colo")) == (Names{"color", "colormap"}));
+    CHECK(_listed(parser.searchHelp("colors")) == (Names{"colormap"}));
+
+    // Words of names, whatever the case
+    CHECK(_listed(parser.searchHelp("LEVEL")) == (Names{"log-level"}));
+
+    // Every word must match, as a word or a prefix of one
+    CHECK(_listed(parser.searchHelp("print more")) == (Names{"verbose"}));
+    CHECK(_listed(parser.searchHelp("verb")) ==
+          (Names{"verbose", "log-level"}));
+    CHECK(_listed(parser.searchHelp("print less")).empty());
+
+    // Positional arguments as well
+    CHECK(_listed(parser.searchHelp("file")) == (Names{}));
+    CHECK(parser.searchHelp("file").find("INPUT") != std::string::npos);
+
+    CHECK_EQ(parser.searchHelp("nothing"),
+             "No options matching 'nothing'\n");
+}
+
+static void testRebuild() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    CHECK(_listed(parser.searchHelp("timeout")).empty());
+
+    // Arguments added after a search are found by the next one
+    parser.addArgument({
+        .long_opt = "timeout",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Seconds to wait for the output",
+    });
+    CHECK(_listed(parser.searchHelp("timeout")) == (Names{"timeout"}));
+    CHECK(_listed(parser.searchHelp("output")) ==
+          (Names{"output", "color", "verbose", "timeout"}));
+}
+
+static void testLarge() {
+    constexpr int N = 5000;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    std::vector<std::string> names;
+    for (int i = 0; i < N; ++i) names.push_back("gen-" + std::to_string(i));
+    for (int i = 0; i < N; ++i) {
+        parser.addArgument({
+            .long_opt = names[i].c_str(),
+            .help = (i % 1000) ? "Generated" : "Generated milestone",
+        });
+    }
+
+    CHECK(_listed(parser.searchHelp("milestone")) ==
+          (Names{"gen-0", "gen-1000", "gen-2000", "gen-3000", "gen-4000"}));
+    CHECK(_listed(parser.searchHelp("gen-4999")) == (Names{"gen-4999"}));
+    CHECK_EQ(_listed(parser.searchHelp("gen-49")).size(), 111U);
+}
+
+int main() {
+    testRanking();
+    testRebuild();
+    testLarge();
+    return test::result();
+}
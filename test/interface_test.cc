@@ -0,0 +1,54 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <memory>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::Options;
+
+// Written against the first release, which ParserInterface still is
+class Minimal : public cmdarg::ParserInterface {
+ public:
+    std::vector<std::string> names;
+
+    int addArgument(const Argument &arg_options) override {
+        names.emplace_back(arg_options.long_opt);
+        return 0;
+    }
+
+    Options parse(int argc, char *const /*argv*/[]) override {
+        return {{"argc", std::to_string(argc)}};
+    }
+
+    void clear() override {
+        names.clear();
+    }
+
+    std::string getHelp() const override {
+        return "help of minimal\n";
+    }
+};
+
+static void testMinimal() {
+    std::unique_ptr<cmdarg::ParserInterface> parser =
+        std::make_unique<Minimal>();
+
+    CHECK_EQ(parser->addArgument({.long_opt = "one"}), 0);
+    char prog[] = "prog";
+    char one[] = "--one";
+    char *argv[] = {prog, one, nullptr};
+    CHECK_EQ(parser->parse(2, argv).at("argc"), "2");
+    CHECK_EQ(parser->getHelp(), "help of minimal\n");
+    parser->clear();
+}
+
+int main() {
+    testMinimal();
+    return test::result();
+}
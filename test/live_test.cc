@@ -0,0 +1,220 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+static const char *_PATH = "live_test.ini";
+
+static void _write(const std::string &content) {
+    std::ofstream file{_PATH};
+    file << content;
+}
+
+// Both values are always written together, readers check that they match
+static void _write_generation(int generation) {
+    const std::string value = std::to_string(generation);
+    _write("first = " + value + "\nsecond = " + value + "\n");
+}
+
+// Makes the action of --mode ask for the help, as --help does
+static bool _help_requested = false;
+
+static int _store_mode(std::string *dest, const Argument & /*opt*/,
+                       const std::string &src) {
+    *dest = src;
+    return _help_requested ? -1 : 0;
+}
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    for (const char *name : {"first", "second"}) {
+        parser->addArgument({
+            .long_opt = name,
+            .parameter_required = Argument::ParameterRequired::REQUIRED,
+            .default_value = "0",
+            .action = cmdarg::actions::store_int,
+        });
+    }
+    parser->addArgument({
+        .long_opt = "mode",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = _store_mode,
+    });
+}
+
+static void testReload() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    _write_generation(1);
+    CHECK_EQ(parser.loadConfig(_PATH), 0);
+
+    char prog[] = "prog";
+    char mode[] = "--mode=x";
+    char *argv[] = {prog, mode, nullptr};
+    cmdarg::LiveOptions live{&parser, 2, argv};
+    CHECK_EQ(live.generation(), 1U);
+
+    {
+        cmdarg::LiveOptions::Reader reader{&live};
+        {
+            cmdarg::LiveOptions::ReadLock lock{&reader};
+            CHECK_EQ(lock->at("first"), "1");
+        }
+
+        _write_generation(2);
+        CHECK_EQ(live.reload(), 0);
+        CHECK_EQ(live.generation(), 2U);
+        {
+            cmdarg::LiveOptions::ReadLock lock{&reader};
+            CHECK_EQ(lock->at("first"), "2");
+            CHECK_EQ((*lock).at("second"), "2");
+        }
+
+        // Failed reloads keep the old snapshot published
+        _write("first = 3\nbroken\n");
+        CHECK_EQ(live.reload(), 2);
+
+        const bool quiet = cmdarg::actions::setQuiet(true);
+        _write("first = x\n");
+        CHECK_EQ(live.reload(), -2);
+        cmdarg::actions::setQuiet(quiet);
+        CHECK(parser.lastError().kind ==
+              cmdarg::ParseError::Kind::INVALID_VALUE);
+
+        // Help requests would terminate the program
+        _write_generation(3);
+        _help_requested = true;
+        CHECK_EQ(live.reload(), -2);
+        _help_requested = false;
+        CHECK(parser.lastError().kind ==
+              cmdarg::ParseError::Kind::HELP_REQUESTED);
+
+        std::remove(_PATH);
+        CHECK_EQ(live.reload(), -1);
+
+        CHECK_EQ(live.generation(), 2U);
+        cmdarg::LiveOptions::ReadLock lock{&reader};
+        CHECK_EQ(lock->at("first"), "2");
+        CHECK_EQ(lock->at("mode"), "x");
+    }
+
+    // Slots of destroyed readers are reused
+    for (int i = 0; i < 4; ++i) {
+        cmdarg::LiveOptions::Reader reader{&live};
+        cmdarg::LiveOptions::ReadLock lock{&reader};
+        CHECK_EQ(lock->at("second"), "2");
+    }
+}
+
+static void _setup_run(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "mode",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = _store_mode,
+    });
+}
+
+// Subcommands are parsed with the settings of the reload as well
+static void testReloadSubcommand() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+
+    char prog[] = "prog";
+    char run[] = "run";
+    char mode[] = "--mode=x";
+    char *argv[] = {prog, run, mode, nullptr};
+    cmdarg::LiveOptions live{&parser, 3, argv};
+
+    _help_requested = true;
+    CHECK_EQ(live.reload(), -2);
+    _help_requested = false;
+    CHECK(parser.lastError().kind == cmdarg::ParseError::Kind::HELP_REQUESTED);
+    CHECK_EQ(live.generation(), 1U);
+}
+
+// Reloads leave the setting of the caller as they found it
+static void testReloadKeepsExitOnHelp() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    _write_generation(1);
+    CHECK_EQ(parser.loadConfig(_PATH), 0);
+    parser.setExitOnHelp(false);
+
+    char prog[] = "prog";
+    char *argv[] = {prog, nullptr};
+    cmdarg::LiveOptions live{&parser, 1, argv};
+    CHECK_EQ(live.reload(), 0);
+    CHECK(!parser.exitOnHelp());
+
+    parser.setExitOnHelp(true);
+    CHECK_EQ(live.reload(), 0);
+    CHECK(parser.exitOnHelp());
+
+    std::remove(_PATH);
+}
+
+static void testConcurrentReaders() {
+    constexpr int READERS = 4;
+    constexpr int RELOADS = 200;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    _write_generation(0);
+    CHECK_EQ(parser.loadConfig(_PATH), 0);
+
+    char prog[] = "prog";
+    char *argv[] = {prog, nullptr};
+    cmdarg::LiveOptions live{&parser, 1, argv};
+
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> backwards{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READERS; ++i) {
+        readers.emplace_back([&]() {
+            cmdarg::LiveOptions::Reader reader{&live};
+            int last = 0;
+            while (!done.load()) {
+                cmdarg::LiveOptions::ReadLock lock{&reader};
+                const int first = std::stoi(lock->at("first"));
+                if (lock->at("second") != lock->at("first")) ++torn;
+                if (first < last) ++backwards;
+                last = first;
+            }
+        });
+    }
+
+    int failed = 0;
+    for (int i = 1; i <= RELOADS; ++i) {
+        _write_generation(i);
+        if (live.reload()) ++failed;
+    }
+    done.store(true);
+    for (auto &reader : readers) reader.join();
+
+    CHECK_EQ(failed, 0);
+    CHECK_EQ(torn.load(), 0);
+    CHECK_EQ(backwards.load(), 0);
+    CHECK_EQ(live.generation(), RELOADS + 1U);
+
+    std::remove(_PATH);
+}
+
+int main() {
+    testReload();
+    testReloadSubcommand();
+    testReloadKeepsExitOnHelp();
+    testConcurrentReaders();
+    return test::result();
+}
@@ -0,0 +1,156 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+using cmdarg::Payload;
+
+static const char *_PATH = "payload_test.json";
+
+static void _write(const std::string &content) {
+    std::ofstream file{_PATH};
+    file << content;
+}
+
+static void testInline() {
+    std::string_view text;
+
+    Payload plain{"{\"a\": 1}"};
+    CHECK(!plain.isFile());
+    CHECK_EQ(plain.path(), "");
+    CHECK_EQ(plain.read(&text), 0);
+    CHECK_EQ(text, "{\"a\": 1}");
+
+    // "@@" escapes a leading '@'
+    Payload escaped{"@@handle"};
+    CHECK(!escaped.isFile());
+    CHECK_EQ(escaped.read(&text), 0);
+    CHECK_EQ(text, "@handle");
+
+    Payload at{"@"};
+    CHECK(!at.isFile());
+    CHECK_EQ(at.read(&text), 0);
+    CHECK_EQ(text, "@");
+
+    Payload empty{""};
+    CHECK_EQ(empty.read(&text), 0);
+    CHECK_EQ(text, "");
+}
+
+static void testFile() {
+    std::remove(_PATH);
+    std::string_view text;
+
+    // Nothing is opened until the first read, failures are retried
+    Payload payload{std::string("@") + _PATH};
+    CHECK(payload.isFile());
+    CHECK_EQ(payload.path(), _PATH);
+    CHECK_EQ(payload.read(&text), -1);
+    CHECK(payload.error().find("cannot open") != std::string::npos);
+
+    _write("{\"policy\": true}");
+    CHECK_EQ(payload.read(&text), 0);
+    CHECK_EQ(text, "{\"policy\": true}");
+    CHECK_EQ(payload.error(), "");
+
+    // Copies share the mapping, read once
+    std::optional<Payload> copy{payload};
+    std::string_view shared;
+    CHECK_EQ(copy->read(&shared), 0);
+    CHECK(shared.data() == text.data());
+    copy.reset();
+    CHECK_EQ(text, "{\"policy\": true}");
+
+    _write("");
+    Payload empty{std::string("@") + _PATH};
+    CHECK_EQ(empty.read(&text), 0);
+    CHECK_EQ(text.size(), 0U);
+
+    _write("0123456789");
+    Payload large{std::string("@") + _PATH, 9};
+    CHECK_EQ(large.read(&text), -2);
+    CHECK(large.error().find("too large") != std::string::npos);
+    Payload exact{std::string("@") + _PATH, 10};
+    CHECK_EQ(exact.read(&text), 0);
+    CHECK_EQ(text, "0123456789");
+
+    std::remove(_PATH);
+}
+
+static void testStream() {
+    int fds[2];
+    CHECK_EQ(::pipe(fds), 0);
+    const std::string path = "/proc/self/fd/" + std::to_string(fds[0]);
+
+    // Pipes report no size, their content is read instead of mapped
+    CHECK_EQ(::write(fds[1], "from a pipe", 11), 11);
+    ::close(fds[1]);
+
+    Payload payload{"@" + path};
+    std::string_view text;
+    CHECK_EQ(payload.read(&text), 0);
+    CHECK_EQ(text, "from a pipe");
+    ::close(fds[0]);
+
+    // Still enforcing the limit
+    CHECK_EQ(::pipe(fds), 0);
+    CHECK_EQ(::write(fds[1], "0123456789", 10), 10);
+    ::close(fds[1]);
+
+    Payload large{"@/proc/self/fd/" + std::to_string(fds[0]), 4};
+    CHECK_EQ(large.read(&text), -2);
+    ::close(fds[0]);
+}
+
+static void testAction() {
+    std::remove(_PATH);
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addArgument({
+        .long_opt = "policy",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_payload,
+    });
+
+    // The file is not looked at while parsing
+    const std::string value = std::string("@") + _PATH;
+    const std::string_view argv[] = {"prog", "--policy", value};
+    auto values = parser.parse(3, argv);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("policy"), value);
+
+    _write("allow all");
+    Payload policy{values.at("policy")};
+    std::string_view text;
+    CHECK_EQ(policy.read(&text), 0);
+    CHECK_EQ(text, "allow all");
+
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view missing[] = {"prog", "--policy=@"};
+    parser.parse(2, missing);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+
+    std::remove(_PATH);
+}
+
+int main() {
+    testInline();
+    testFile();
+    testStream();
+    testAction();
+    return test::result();
+}
@@ -0,0 +1,176 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+// Arguments the test runs itself again with, to have a command line to read
+static const char *const _CHILD_ARGS[] = {
+    "--child", "--trace.level=3", "-v", "--trace.file", "out.log", "",
+    "--net.bogus", "file", "--level=2", "--", "--trace.level=9",
+};
+
+static void _add_trace(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "trace.level",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "0",
+        .action = cmdarg::actions::store_int,
+    });
+    parser->addArgument({
+        .long_opt = "trace.file",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "trace.log",
+    });
+}
+
+// Asks for the help, as --help does
+static int _ask_help(std::string * /*dest*/, const Argument & /*opt*/,
+                     const std::string & /*src*/) {
+    return -1;
+}
+
+static void testNamespace() {
+    cmdarg::Parser parser{{.prog = "libtrace"}};
+    parser.setErrorHandler(test::keepError);
+    _add_trace(&parser);
+
+    // Everything else is skipped, up to "--"
+    const std::string_view argv[] = {
+        "prog",    "--trace.level", "4",       "-t",
+        "--trace", "--traced=1",    "--help",  "--other",
+        "value",   "--trace.file=x", "--",     "--trace.level=9",
+    };
+    auto values = parser.parseNamespace(12, argv, "trace");
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("trace.level"), "4");
+    CHECK_EQ(values.at("trace.file"), "x");
+
+    // Within the namespace, prefixes are taken as parse does, with their
+    // values in the next word as well
+    const std::string_view prefix[] = {"prog", "--trace.lev=1"};
+    values = parser.parseNamespace(2, prefix, "trace");
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("trace.level"), "1");
+
+    const std::string_view split[] = {"prog", "--trace.lev", "2", "--trace.f",
+                                      "y", "file"};
+    values = parser.parseNamespace(6, split, "trace");
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("trace.level"), "2");
+    CHECK_EQ(values.at("trace.file"), "y");
+
+    const std::string_view unknown[] = {"prog", "--trace.bogus"};
+    parser.parseNamespace(2, unknown, "trace");
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+
+    // Without a namespace, only options known to the parser
+    cmdarg::Parser plain{{.prog = "lib"}};
+    plain.setErrorHandler(test::keepError);
+    plain.addArgument({
+        .long_opt = "level",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "0",
+    });
+    const std::string_view mixed[] = {"prog", "--lev=1", "--program-opt",
+                                      "--level", "5", "--help"};
+    values = plain.parseNamespace(6, mixed, "");
+    CHECK(!plain.lastError());
+    CHECK_EQ(values.at("level"), "5");
+
+    // No words at all
+    values = plain.parseNamespace(0, mixed, "");
+    CHECK(!plain.lastError());
+    CHECK_EQ(values.at("level"), "0");
+}
+
+// Runs in the child, with _CHILD_ARGS on its command line
+static void testProcess(int argc, char *argv[]) {
+    const std::string_view *words;
+    CHECK_EQ(cmdarg::process::arguments(&words), argc);
+    for (int i = 0; i < argc; ++i) {
+        CHECK_EQ(words[i], argv[i]);
+    }
+
+    // Read once, shared by every thread
+    std::vector<const std::string_view *> seen(4);
+    std::vector<std::thread> threads;
+    for (auto &out : seen) {
+        threads.emplace_back([&out]() { cmdarg::process::arguments(&out); });
+    }
+    for (auto &thread : threads) thread.join();
+    for (const auto *other : seen) CHECK(other == words);
+
+    cmdarg::Parser trace{{.prog = "libtrace"}};
+    _add_trace(&trace);
+    auto values = cmdarg::process::parse(&trace, "trace");
+    CHECK(!trace.lastError());
+    CHECK_EQ(values.at("trace.level"), "3");
+    CHECK_EQ(values.at("trace.file"), "out.log");
+
+    // Errors never terminate the program, the handler is left as it was
+    cmdarg::Parser net{{.prog = "libnet"}};
+    net.addArgument({.long_opt = "net.port"});
+    cmdarg::process::parse(&net, "net");
+    CHECK(net.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+    CHECK_EQ(net.lastError().token, "--net.bogus");
+    CHECK(net.errorHandler() == nullptr);
+
+    net.setErrorHandler(test::keepError);
+    cmdarg::process::parse(&net, "net");
+    CHECK(net.errorHandler() == test::keepError);
+
+    // Nor do help requests, exit on help is left as it was
+    cmdarg::Parser asking{{.prog = "libtrace"}};
+    asking.addArgument({
+        .long_opt = "trace.level",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = _ask_help,
+    });
+    cmdarg::process::parse(&asking, "trace");
+    CHECK(asking.lastError().kind == ParseError::Kind::HELP_REQUESTED);
+    CHECK(asking.exitOnHelp());
+}
+
+static void testChild(char *self) {
+    std::vector<char *> argv = {self};
+    for (const char *arg : _CHILD_ARGS) {
+        argv.push_back(const_cast<char *>(arg));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::execv("/proc/self/exe", argv.data());
+        ::_exit(127);
+    }
+
+    int status = 0;
+    CHECK(pid > 0);
+    CHECK_EQ(::waitpid(pid, &status, 0), pid);
+    CHECK(WIFEXITED(status));
+    CHECK_EQ(WEXITSTATUS(status), 0);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::string_view{argv[1]} == "--child") {
+        testProcess(argc, argv);
+        return test::result();
+    }
+
+    testNamespace();
+    testChild(argv[0]);
+    return test::result();
+}
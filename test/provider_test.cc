@@ -0,0 +1,181 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ValueReader;
+
+static int _threads_calls = 0;
+static int _failures_left = 0;
+
+static int _threads(std::string *dest, ValueReader * /*values*/) {
+    ++_threads_calls;
+    *dest = "8";
+    return 0;
+}
+
+// Two per thread
+static int _workers(std::string *dest, ValueReader *values) {
+    std::string threads;
+    int res = values->value("threads", &threads);
+    if (res) return res;
+
+    *dest = std::to_string(2 * std::stoi(threads));
+    return 0;
+}
+
+static int _flaky(std::string *dest, ValueReader * /*values*/) {
+    if (_failures_left > 0) {
+        --_failures_left;
+        return 7;
+    }
+    *dest += "-computed";
+    return 0;
+}
+
+static int _ping(std::string *dest, ValueReader *values) {
+    return values->value("pong", dest);
+}
+
+static int _pong(std::string *dest, ValueReader *values) {
+    return values->value("ping", dest);
+}
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "threads",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "1",
+        .action = cmdarg::actions::store_positive_int,
+        .env = "PROVIDER_TEST_THREADS",
+        .default_provider = _threads,
+    });
+    parser->addArgument({
+        .long_opt = "workers",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "1",
+        .default_provider = _workers,
+    });
+    parser->addArgument({
+        .long_opt = "flaky",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "base",
+        .default_provider = _flaky,
+    });
+    parser->addArgument({
+        .long_opt = "ping",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_provider = _ping,
+    });
+    parser->addArgument({
+        .long_opt = "pong",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_provider = _pong,
+    });
+    parser->addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "plain",
+    });
+}
+
+static void testLazy() {
+    ::unsetenv("PROVIDER_TEST_THREADS");
+    _threads_calls = 0;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // Parsing never computes anything, the map keeps default_value
+    const std::string_view empty[] = {"prog"};
+    auto values = parser.parse(1, empty);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("threads"), "1");
+    CHECK_EQ(_threads_calls, 0);
+
+    // Once per parse, on the first read
+    std::string value;
+    CHECK_EQ(parser.value("threads", &value), 0);
+    CHECK_EQ(value, "8");
+    CHECK_EQ(parser.value("threads", &value), 0);
+    CHECK_EQ(_threads_calls, 1);
+
+    // Reading other values
+    CHECK_EQ(parser.value("workers", &value), 0);
+    CHECK_EQ(value, "16");
+    CHECK_EQ(_threads_calls, 1);
+
+    CHECK_EQ(parser.value("name", &value), 0);
+    CHECK_EQ(value, "plain");
+    CHECK_EQ(parser.value("missing", &value), -1);
+
+    parser.parse(1, empty);
+    CHECK_EQ(parser.value("workers", &value), 0);
+    CHECK_EQ(value, "16");
+    CHECK_EQ(_threads_calls, 2);
+}
+
+static void testLayers() {
+    _threads_calls = 0;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // Any layer setting the value wins over the provider
+    const std::string_view given[] = {"prog", "--threads=3"};
+    parser.parse(2, given);
+    std::string value;
+    CHECK_EQ(parser.value("threads", &value), 0);
+    CHECK_EQ(value, "3");
+    CHECK_EQ(parser.value("workers", &value), 0);
+    CHECK_EQ(value, "6");
+
+    ::setenv("PROVIDER_TEST_THREADS", "5", 1);
+    const std::string_view empty[] = {"prog"};
+    parser.parse(1, empty);
+    ::unsetenv("PROVIDER_TEST_THREADS");
+    CHECK_EQ(parser.value("threads", &value), 0);
+    CHECK_EQ(value, "5");
+    CHECK(parser.source("threads") == cmdarg::Source::ENVIRONMENT);
+
+    CHECK_EQ(_threads_calls, 0);
+}
+
+static void testFailures() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    const std::string_view empty[] = {"prog"};
+    parser.parse(1, empty);
+
+    std::string value = "untouched";
+    CHECK_EQ(parser.value("ping", &value), -2);
+    CHECK_EQ(parser.value("pong", &value), -2);
+    CHECK_EQ(value, "untouched");
+
+    // Failing providers are called again, starting from default_value
+    _failures_left = 2;
+    CHECK_EQ(parser.value("flaky", &value), 7);
+    CHECK_EQ(parser.value("flaky", &value), 7);
+    CHECK_EQ(parser.value("flaky", &value), 0);
+    CHECK_EQ(value, "base-computed");
+    CHECK_EQ(parser.value("flaky", &value), 0);
+    CHECK_EQ(value, "base-computed");
+}
+
+int main() {
+    testLazy();
+    testLayers();
+    testFailures();
+    return test::result();
+}
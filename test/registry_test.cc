@@ -0,0 +1,138 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+// Blocks as libraries would declare them, in no particular order
+
+static const Argument _net_options[] = {
+    {
+        .long_opt = "port",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Port to listen on",
+        .default_value = "80",
+        .action = cmdarg::actions::store_positive_int,
+    },
+    {
+        .long_opt = "ipv6",
+        .help = "Use IPv6",
+        .action = cmdarg::actions::store_true,
+    },
+};
+CMDARG_REGISTER_OPTIONS("net", _net_options);
+
+static const Argument _global_options[] = {
+    {.long_opt = "verbose", .short_opt = 'v', .help = "Be verbose"},
+};
+CMDARG_REGISTER_OPTIONS(nullptr, _global_options);
+
+static const Argument _db_pool_options[] = {
+    {
+        .long_opt = "pool",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Connections kept open",
+        .default_value = "4",
+    },
+};
+static const Argument _db_url_options[] = {
+    {
+        .long_opt = "url",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "Database to connect to",
+        .default_value = "sqlite://",
+    },
+};
+
+// Two blocks of the same namespace on the same line, as a macro would
+#define REGISTER_DB(a, b)         \
+    CMDARG_REGISTER_OPTIONS("db", a); \
+    CMDARG_REGISTER_OPTIONS("db", b)
+REGISTER_DB(_db_url_options, _db_pool_options);
+
+// Registered only when first called, as a library loaded later would
+static const Argument _late_options[] = {
+    {.long_opt = "late", .help = "Registered late"},
+};
+static void _register_late() {
+    static cmdarg::OptionBlock block{"plugin", _late_options};
+}
+
+static void testApply() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    CHECK_EQ(cmdarg::registry::apply(&parser), 0);
+
+    const std::string_view argv[] = {"prog", "--net.port=8080", "-v",
+                                     "--db.pool", "16"};
+    auto values = parser.parse(5, argv);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("net.port"), "8080");
+    CHECK_EQ(values.at("net.ipv6"), "");
+    CHECK_EQ(values.count("verbose"), 1U);
+    CHECK_EQ(values.at("db.pool"), "16");
+    CHECK_EQ(values.at("db.url"), "sqlite://");
+
+    // Actions and help as declared
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view invalid[] = {"prog", "--net.port=-1"};
+    parser.parse(2, invalid);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == cmdarg::ParseError::Kind::INVALID_VALUE);
+
+    // By namespace, blocks of the same one by first option name, options
+    // as declared
+    const std::string help = parser.getHelp();
+    std::size_t at = 0;
+    for (const char *name : {"--verbose", "--db.pool", "--db.url",
+                             "--net.port", "--net.ipv6"}) {
+        at = help.find(name, at);
+        CHECK(at != std::string::npos);
+    }
+    CHECK(help.find("Connections kept open") != std::string::npos);
+}
+
+static void testConflicts() {
+    // Nothing is added if any name is taken
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addArgument({.long_opt = "net.port"});
+    CHECK(cmdarg::registry::apply(&parser) != 0);
+    CHECK(parser.getHelp().find("--db.url") == std::string::npos);
+
+    // Once per parser
+    cmdarg::Parser twice{{.prog = "prog"}};
+    CHECK_EQ(cmdarg::registry::apply(&twice), 0);
+    CHECK(cmdarg::registry::apply(&twice) != 0);
+}
+
+static void testLate() {
+    cmdarg::Parser before{{.prog = "prog"}};
+    CHECK_EQ(cmdarg::registry::apply(&before), 0);
+    CHECK(before.getHelp().find("--plugin.late") == std::string::npos);
+
+    // Merged again with the new block
+    _register_late();
+    cmdarg::Parser after{{.prog = "prog"}};
+    CHECK_EQ(cmdarg::registry::apply(&after), 0);
+    const std::string help = after.getHelp();
+    CHECK(help.find("--plugin.late") != std::string::npos);
+    CHECK(help.find("--net.port") < help.find("--plugin.late"));
+
+    const std::string_view argv[] = {"prog", "--plugin.late"};
+    auto values = after.parse(2, argv);
+    CHECK_EQ(values.count("plugin.late"), 1U);
+    CHECK_EQ(values.count("db.url"), 1U);
+}
+
+int main() {
+    testApply();
+    testConflicts();
+    testLate();
+    return test::result();
+}
@@ -0,0 +1,233 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::Source;
+
+// Images must be aligned to 8 bytes
+using Image = std::vector<std::uint64_t>;
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "5",
+        .action = cmdarg::actions::store_int,
+    });
+    parser->addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "none",
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .action = cmdarg::actions::store_true,
+    });
+}
+
+static Image _image(const std::string &bytes) {
+    Image image((bytes.size() + 7) / 8);
+    std::memcpy(image.data(), bytes.data(), bytes.size());
+    return image;
+}
+
+static void testRoundTrip() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    const std::string_view argv[] = {"prog", "-c", "12", "-v"};
+    auto values = parser.parse(4, argv);
+
+    std::string bytes;
+    CHECK_EQ(parser.saveResults(values, &bytes), 0);
+    CHECK_EQ(bytes.size() % 8, 0U);
+
+    Image image = _image(bytes);
+    cmdarg::ResultsView view;
+    CHECK(view.empty());
+    CHECK_EQ(view.size(), 0U);
+    CHECK_EQ(view.open(image.data(), bytes.size(), parser.schemaHash()), 0);
+    CHECK(!view.empty());
+
+    CHECK_EQ(view.size(), values.size());
+    CHECK(view.toOptions() == values);
+
+    CHECK_EQ(std::string(view.get("count")), "12");
+    CHECK_EQ(std::string(view.get("name")), "none");
+    CHECK(view.get("missing") == nullptr);
+    CHECK(view.get("") == nullptr);
+
+    // Sorted by key, with the sources of the values
+    for (std::size_t i = 0; i < view.size(); ++i) {
+        if (i) CHECK(view.key(i - 1) < view.key(i));
+        const bool given = view.key(i) == "count" || view.key(i) == "verbose";
+        const Source expected = given ? Source::COMMAND_LINE : Source::DEFAULT;
+        CHECK(view.source(i) == expected);
+    }
+
+    // Another parser set up the same way reads it as well
+    cmdarg::Parser worker{{.prog = "worker"}};
+    _add_arguments(&worker);
+    CHECK_EQ(worker.schemaHash(), parser.schemaHash());
+    cmdarg::ResultsView copy;
+    CHECK_EQ(copy.open(image.data(), bytes.size(), worker.schemaHash()), 0);
+    CHECK(copy.toOptions() == values);
+}
+
+static void testBinaryValues() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    // Saved before any parse as well
+    cmdarg::Options values = {
+        {"count", "7"},
+        {"name", std::string("a\0b", 3)},
+        {"verbose", ""},
+    };
+
+    std::string bytes;
+    CHECK_EQ(parser.saveResults(values, &bytes), 0);
+    Image image = _image(bytes);
+
+    cmdarg::ResultsView view;
+    CHECK_EQ(view.open(image.data(), bytes.size(), parser.schemaHash()), 0);
+    CHECK_EQ(view.toOptions().at("name").size(), 3U);
+    CHECK(view.toOptions() == values);
+    CHECK_EQ(std::string(view.get("name")), "a");
+    CHECK_EQ(std::string(view.get("verbose")), "");
+
+    // No values at all
+    CHECK_EQ(parser.saveResults({}, &bytes), 0);
+    image = _image(bytes);
+    CHECK_EQ(view.open(image.data(), bytes.size(), parser.schemaHash()), 0);
+    CHECK_EQ(view.size(), 0U);
+    CHECK(view.get("count") == nullptr);
+}
+
+static void testTransport() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    const std::string_view argv[] = {"prog", "--name=worker"};
+    auto values = parser.parse(2, argv);
+
+    std::string bytes;
+    CHECK_EQ(parser.saveResults(values, &bytes), 0);
+
+    // Through a memfd
+    int fd = cmdarg::results::toMemfd(bytes);
+    CHECK(fd >= 0);
+    cmdarg::ResultsView mapped;
+    CHECK_EQ(mapped.mapFd(fd, parser.schemaHash()), 0);
+    ::close(fd);
+    CHECK(mapped.toOptions() == values);
+
+    // Copies keep the mapping alive
+    cmdarg::ResultsView copy = mapped;
+    mapped = cmdarg::ResultsView{};
+    CHECK_EQ(std::string(copy.get("name")), "worker");
+
+    // The memfd is sealed
+    fd = cmdarg::results::toMemfd(bytes);
+    CHECK(::write(fd, "x", 1) < 0);
+    ::close(fd);
+
+    CHECK_EQ(mapped.mapFd(-1, parser.schemaHash()), -5);
+
+    // Through the environment, whatever the size modulo 3
+    for (const char *name : {"w", "wo", "wor"}) {
+        values["name"] = name;
+        CHECK_EQ(parser.saveResults(values, &bytes), 0);
+        CHECK_EQ(cmdarg::results::toEnv("RESULTS_TEST", bytes), 0);
+
+        cmdarg::ResultsView decoded;
+        CHECK_EQ(decoded.fromEnv("RESULTS_TEST", parser.schemaHash()), 0);
+        CHECK(decoded.toOptions() == values);
+    }
+
+    cmdarg::ResultsView decoded;
+    ::setenv("RESULTS_TEST", "not*base64", 1);
+    CHECK_EQ(decoded.fromEnv("RESULTS_TEST", parser.schemaHash()), -1);
+    ::unsetenv("RESULTS_TEST");
+    CHECK_EQ(decoded.fromEnv("RESULTS_TEST", parser.schemaHash()), -5);
+    CHECK(decoded.empty());
+}
+
+static void testReject() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    const std::string_view argv[] = {"prog", "-c", "3"};
+    std::string bytes;
+    CHECK_EQ(parser.saveResults(parser.parse(3, argv), &bytes), 0);
+    const std::uint64_t hash = parser.schemaHash();
+
+    cmdarg::ResultsView view;
+    Image image = _image(bytes);
+    CHECK_EQ(view.open(nullptr, bytes.size(), hash), -1);
+    CHECK_EQ(view.open(image.data(), 16, hash), -1);
+    CHECK_EQ(view.open(image.data(), bytes.size() - 8, hash), -1);
+
+    // Misaligned
+    Image shifted(image.size() + 1);
+    char *unaligned = reinterpret_cast<char *>(shifted.data()) + 4;
+    std::memcpy(unaligned, bytes.data(), bytes.size());
+    CHECK_EQ(view.open(unaligned, bytes.size(), hash), -1);
+
+    // Bad magic
+    image = _image(bytes);
+    reinterpret_cast<char *>(image.data())[0] ^= 1;
+    CHECK_EQ(view.open(image.data(), bytes.size(), hash), -1);
+
+    // Another format version, right after the magic
+    image = _image(bytes);
+    std::uint32_t version;
+    std::memcpy(&version, reinterpret_cast<char *>(image.data()) + 8, 4);
+    ++version;
+    std::memcpy(reinterpret_cast<char *>(image.data()) + 8, &version, 4);
+    CHECK_EQ(view.open(image.data(), bytes.size(), hash), -2);
+
+    // Anything past the version is covered by the checksum, header included
+    image = _image(bytes);
+    reinterpret_cast<char *>(image.data())[bytes.size() / 2] ^= 0x20;
+    CHECK_EQ(view.open(image.data(), bytes.size(), hash), -3);
+    // (the schema hash, the number of values and the size of the strings)
+    for (std::size_t at : {32, 40, 52}) {
+        image = _image(bytes);
+        reinterpret_cast<char *>(image.data())[at] ^= 1;
+        CHECK_EQ(view.open(image.data(), bytes.size(), hash), -3);
+    }
+
+    // Results of another parser
+    image = _image(bytes);
+    cmdarg::Parser other{{.prog = "prog"}};
+    _add_arguments(&other);
+    other.addArgument({.long_opt = "extra"});
+    CHECK(other.schemaHash() != hash);
+    CHECK_EQ(view.open(image.data(), bytes.size(), other.schemaHash()), -4);
+
+    CHECK(view.empty());
+}
+
+int main() {
+    testRoundTrip();
+    testBinaryValues();
+    testTransport();
+    testReject();
+    return test::result();
+}
@@ -0,0 +1,232 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+
+// Blobs must be aligned to 8 bytes
+using Blob = std::vector<std::uint64_t>;
+
+static const char *const _MODES[] = {"fast", "slow", nullptr};
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .help = "How many times",
+        .default_value = "5",
+        .action = cmdarg::actions::store_int,
+    });
+    parser->addArgument({
+        .long_opt = "mode",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "fast",
+        .action = cmdarg::actions::store_choice,
+        .choices = _MODES,
+        .env = "SCHEMA_TEST_MODE",
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .action = cmdarg::actions::store_true,
+    });
+    parser->addArgument({.long_opt = "file", .required = true});
+}
+
+static std::string _save(cmdarg::Parser *parser, int *res) {
+    std::ostringstream oss;
+    *res = parser->saveSchema(&oss);
+    return oss.str();
+}
+
+static Blob _blob(const std::string &bytes) {
+    Blob blob((bytes.size() + 7) / 8);
+    std::memcpy(blob.data(), bytes.data(), bytes.size());
+    return blob;
+}
+
+static void testRoundTrip() {
+    cmdarg::Parser built{{.prog = "prog"}};
+    _add_arguments(&built);
+
+    int res;
+    const std::string bytes = _save(&built, &res);
+    CHECK_EQ(res, 0);
+    CHECK(!bytes.empty());
+
+    // Saving is deterministic
+    CHECK(_save(&built, &res) == bytes);
+
+    const Blob blob = _blob(bytes);
+    cmdarg::Parser loaded{{.prog = "prog"}};
+    loaded.setErrorHandler(test::keepError);
+    loaded.addArgument({.long_opt = "replaced"});
+    CHECK_EQ(loaded.loadSchema(blob.data(), bytes.size()), 0);
+
+    CHECK_EQ(loaded.schemaHash(), built.schemaHash());
+    CHECK_EQ(loaded.getHelp(), built.getHelp());
+
+    const std::string_view argv[] = {"prog", "-vc", "7", "--mode=slow", "in"};
+    auto expected = built.parse(5, argv);
+    auto values = loaded.parse(5, argv);
+    CHECK(!loaded.lastError());
+    CHECK(values == expected);
+    CHECK_EQ(values["count"], "7");
+    CHECK_EQ(values["file"], "in");
+    CHECK_EQ(values.count("replaced"), 0U);
+
+    // Lookups, defaults and choices come from the blob
+    const std::string_view defaults[] = {"prog", "--verb", "in"};
+    values = loaded.parse(3, defaults);
+    CHECK_EQ(values["count"], "5");
+    CHECK_EQ(values["mode"], "fast");
+    CHECK_EQ(values["verbose"], "true");
+
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view invalid[] = {"prog", "--mode", "slwo", "in"};
+    loaded.parse(4, invalid);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(loaded.lastError().kind == cmdarg::ParseError::Kind::INVALID_VALUE);
+    CHECK_EQ(loaded.lastError().suggestions.front(), "slow");
+
+    // Saving a loaded schema gives the same blob
+    CHECK(_save(&loaded, &res) == bytes);
+
+    // Arguments can still be added on top
+    CHECK_EQ(loaded.addArgument({.long_opt = "extra"}), 0);
+    CHECK(loaded.schemaHash() != built.schemaHash());
+}
+
+static void testMap() {
+    cmdarg::Parser built{{.prog = "prog"}};
+    _add_arguments(&built);
+
+    const char *path = "schema_test.bin";
+    {
+        std::ofstream file{path, std::ios::binary};
+        CHECK_EQ(built.saveSchema(&file), 0);
+    }
+
+    cmdarg::Parser mapped{{.prog = "prog"}};
+    CHECK_EQ(mapped.mapSchema(path), 0);
+    std::remove(path);
+
+    // Still mapped after the file is gone
+    const std::string_view argv[] = {"prog", "-c", "3", "in"};
+    auto values = mapped.parse(4, argv);
+    CHECK_EQ(values["count"], "3");
+    CHECK(values == built.parse(4, argv));
+    CHECK_EQ(mapped.schemaHash(), built.schemaHash());
+
+    // Dispatched straight from the blob, choices included, before anything
+    // (e.g. the help) needs all the arguments
+    mapped.setErrorHandler(test::keepError);
+    const std::string_view mode[] = {"prog", "--mode", "slow", "in"};
+    CHECK_EQ(mapped.parse(4, mode)["mode"], "slow");
+
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view invalid[] = {"prog", "--mode=fsat", "in"};
+    mapped.parse(3, invalid);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(mapped.lastError().kind == cmdarg::ParseError::Kind::INVALID_VALUE);
+    CHECK_EQ(mapped.lastError().suggestions.front(), "fast");
+
+    CHECK_EQ(mapped.mapSchema("schema_test.missing"), -5);
+}
+
+static void testReject() {
+    cmdarg::Parser built{{.prog = "prog"}};
+    _add_arguments(&built);
+
+    int res;
+    const std::string bytes = _save(&built, &res);
+    cmdarg::Parser parser{{.prog = "prog"}};
+
+    Blob blob = _blob(bytes);
+    CHECK_EQ(parser.loadSchema(nullptr, bytes.size()), -1);
+    CHECK_EQ(parser.loadSchema(blob.data(), 16), -1);
+    CHECK_EQ(parser.loadSchema(blob.data(), bytes.size() - 1), -1);
+
+    // Misaligned
+    Blob shifted((bytes.size() + 15) / 8);
+    char *unaligned = reinterpret_cast<char *>(shifted.data()) + 4;
+    std::memcpy(unaligned, bytes.data(), bytes.size());
+    CHECK_EQ(parser.loadSchema(unaligned, bytes.size()), -1);
+
+    // Bad magic
+    blob = _blob(bytes);
+    reinterpret_cast<char *>(blob.data())[0] ^= 1;
+    CHECK_EQ(parser.loadSchema(blob.data(), bytes.size()), -1);
+
+    // Another format version, right after the magic
+    blob = _blob(bytes);
+    std::uint32_t version;
+    std::memcpy(&version, reinterpret_cast<char *>(blob.data()) + 8, 4);
+    ++version;
+    std::memcpy(reinterpret_cast<char *>(blob.data()) + 8, &version, 4);
+    CHECK_EQ(parser.loadSchema(blob.data(), bytes.size()), -2);
+
+    // Any other byte is covered by the checksum
+    for (std::size_t i : {bytes.size() / 2, bytes.size() - 2}) {
+        blob = _blob(bytes);
+        reinterpret_cast<char *>(blob.data())[i] ^= 0x20;
+        CHECK_EQ(parser.loadSchema(blob.data(), bytes.size()), -3);
+    }
+
+    // A failed load leaves the parser as it was
+    CHECK_EQ(parser.addArgument({.long_opt = "kept"}), 0);
+    blob = _blob(bytes);
+    reinterpret_cast<char *>(blob.data())[bytes.size() / 2] ^= 0x20;
+    CHECK_EQ(parser.loadSchema(blob.data(), bytes.size()), -3);
+    const std::string_view kept[] = {"prog", "--kept"};
+    CHECK_EQ(parser.parse(2, kept).count("kept"), 1U);
+}
+
+static int _custom(std::string *dest, const Argument & /*opt*/,
+                   const std::string &src) {
+    *dest = src;
+    return 0;
+}
+
+static void _setup(cmdarg::Parser * /*parser*/) {
+}
+
+static void testUnsupported() {
+    cmdarg::Parser custom{{.prog = "prog"}};
+    custom.addArgument({.long_opt = "name", .action = _custom});
+    std::ostringstream oss;
+    CHECK_EQ(custom.saveSchema(&oss), -4);
+
+    cmdarg::Parser commands{{.prog = "prog"}};
+    commands.addSubcommand({.name = "run", .setup = _setup});
+    CHECK_EQ(commands.saveSchema(&oss), -4);
+
+    // Positional arguments cannot be loaded under subcommands
+    cmdarg::Parser built{{.prog = "prog"}};
+    _add_arguments(&built);
+    int res;
+    const std::string bytes = _save(&built, &res);
+    const Blob blob = _blob(bytes);
+    CHECK_EQ(commands.loadSchema(blob.data(), bytes.size()), -4);
+}
+
+int main() {
+    testRoundTrip();
+    testMap();
+    testReject();
+    testUnsupported();
+    return test::result();
+}
@@ -0,0 +1,247 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+using Kind = cmdarg::ParseError::Kind;
+
+// Conversions of --count values
+static int _conversions = 0;
+
+static int _count(std::string *dest, const Argument &opt,
+                  const std::string &src) {
+    ++_conversions;
+    return cmdarg::actions::store_int(dest, opt, src);
+}
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "0",
+        .action = _count,
+    });
+    parser->addArgument({.long_opt = "verbose", .short_opt = 'v'});
+    parser->addArgument({.long_opt = "color"});
+    parser->addArgument({
+        .long_opt = "colormap",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+    });
+    parser->addArgument({.long_opt = "file", .required = true});
+    parser->addArgument({
+        .long_opt = "mode",
+        .required = true,
+        .action = cmdarg::actions::store_positive_int,
+    });
+}
+
+// Errors of session as "position:kind:token"
+static std::vector<std::string> _errors(const cmdarg::Session &session) {
+    std::vector<std::string> out;
+    for (const auto &error : session.errors()) {
+        out.push_back(std::to_string(error.position) + ":" +
+                      std::to_string(static_cast<int>(error.error.kind)) +
+                      ":" + error.error.token);
+    }
+    return out;
+}
+
+static std::string _error(std::size_t position, Kind kind,
+                          const std::string &token) {
+    return std::to_string(position) + ":" +
+           std::to_string(static_cast<int>(kind)) + ":" + token;
+}
+
+using Errors = std::vector<std::string>;
+
+static void testErrors() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    cmdarg::Session session{&parser};
+
+    CHECK_EQ(session.size(), 0U);
+    CHECK_EQ(session.validate(), 1);
+    CHECK_EQ(session.errors()[0].position, 0U);
+    CHECK(session.errors()[0].error.kind == Kind::MISSING_ARGUMENTS);
+
+    // Every word is checked, not only up to the first error
+    const std::string_view line[] = {
+        "--count", "one", "--bogus", "-vz", "--verbose=1", "--col", "in",
+    };
+    session.assign(7, line);
+    CHECK_EQ(session.size(), 7U);
+    CHECK_EQ(session.token(3), "-vz");
+    CHECK_EQ(session.validate(), 6);
+    CHECK(_errors(session) == (Errors{
+                                  _error(1, Kind::INVALID_VALUE, "one"),
+                                  _error(2, Kind::UNKNOWN_OPTION, "--bogus"),
+                                  _error(3, Kind::UNKNOWN_OPTION, "-z"),
+                                  _error(4, Kind::UNEXPECTED_PARAMETER,
+                                         "--verbose"),
+                                  _error(5, Kind::AMBIGUOUS_OPTION, "--col"),
+                                  _error(7, Kind::MISSING_ARGUMENTS, "MODE"),
+                              }));
+
+    const std::string_view extra[] = {"in", "x", "more", "-c"};
+    session.assign(4, extra);
+    CHECK_EQ(session.validate(), 3);
+    CHECK(_errors(session) == (Errors{
+                                  _error(1, Kind::INVALID_VALUE, "x"),
+                                  _error(2, Kind::TOO_MANY_ARGUMENTS, "more"),
+                                  _error(3, Kind::MISSING_PARAMETER, "-c"),
+                              }));
+
+    // Help requests, prefixes and words after "--"
+    const std::string_view valid[] = {"--help", "--verb", "-c7", "--",
+                                      "-in",    "3"};
+    session.assign(6, valid);
+    CHECK_EQ(session.validate(), 0);
+    CHECK(session.errors().empty());
+}
+
+static void testEdits() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    cmdarg::Session session{&parser};
+
+    CHECK_EQ(session.insert(1, "x"), -1);
+    CHECK_EQ(session.remove(0), -1);
+    CHECK_EQ(session.replace(0, "x"), -1);
+
+    CHECK_EQ(session.insert(0, "in"), 0);
+    CHECK_EQ(session.insert(1, "2"), 0);
+    CHECK_EQ(session.insert(0, "-c"), 0);
+    CHECK_EQ(session.insert(1, "1"), 0);
+    CHECK_EQ(session.size(), 4U);
+    CHECK_EQ(session.token(0), "-c");
+    CHECK_EQ(session.token(3), "2");
+
+    _conversions = 0;
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, 1);
+
+    // Unchanged words are not converted again
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, 1);
+    CHECK_EQ(session.replace(1, "one"), 0);
+    CHECK_EQ(session.validate(), 1);
+    CHECK(_errors(session) == (Errors{_error(1, Kind::INVALID_VALUE, "one")}));
+    CHECK_EQ(_conversions, 2);
+    CHECK_EQ(session.replace(1, "12"), 0);
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, 3);
+
+    // Words whose role changed are converted again: "-c" becomes the value
+    // of the inserted option, "12" the file and "in" the mode
+    CHECK_EQ(session.insert(0, "--count"), 0);
+    CHECK_EQ(session.validate(), 3);
+    CHECK(_errors(session) == (Errors{
+                                  _error(1, Kind::INVALID_VALUE, "-c"),
+                                  _error(3, Kind::INVALID_VALUE, "in"),
+                                  _error(4, Kind::TOO_MANY_ARGUMENTS, "2"),
+                              }));
+    CHECK_EQ(_conversions, 4);
+
+    CHECK_EQ(session.remove(0), 0);
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, 5);
+    CHECK_EQ(session.token(0), "-c");
+
+    // Arguments added to the parser, every word is checked again
+    const std::string_view line[] = {"--extra", "-c", "3", "in", "2"};
+    session.assign(5, line);
+    CHECK_EQ(session.validate(), 1);
+    CHECK_EQ(_conversions, 6);
+    parser.addArgument({.long_opt = "extra"});
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, 7);
+}
+
+// The first error of a session is the one a parse reports
+static void testParse() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+    cmdarg::Session session{&parser};
+
+    const std::vector<std::vector<std::string_view>> lines = {
+        {"in", "1"},
+        {"in", "1", "--count"},
+        {"--count=x", "in", "1"},
+        {"--colormap", "red", "in", "-1"},
+        {"in", "1", "2"},
+        {"-vcx", "in", "1"},
+        {"--co", "in", "1"},
+        {"in"},
+        {"-c", "1", "--", "--count", "3"},
+    };
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    for (const auto &line : lines) {
+        std::vector<std::string_view> argv = {"prog"};
+        argv.insert(argv.end(), line.begin(), line.end());
+        parser.parse(argv.size(), argv.data());
+
+        session.assign(line.size(), line.data());
+        const int errors = session.validate();
+        CHECK_EQ(errors > 0, static_cast<bool>(parser.lastError()));
+        if (errors > 0) {
+            CHECK(session.errors()[0].error.kind == parser.lastError().kind);
+        }
+    }
+    cmdarg::actions::setQuiet(quiet);
+}
+
+static void _setup(cmdarg::Parser * /*parser*/) {
+}
+
+static void testSubcommands() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addSubcommand({.name = "run", .setup = _setup});
+
+    cmdarg::Session session{&parser};
+    session.insert(0, "run");
+    CHECK_EQ(session.validate(), -2);
+}
+
+static void testLong() {
+    constexpr std::size_t N = 20000;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+    cmdarg::Session session{&parser};
+
+    std::vector<std::string> words = {"in", "1"};
+    for (std::size_t i = 0; i < N; ++i) {
+        words.push_back("--count=" + std::to_string(i));
+    }
+    const std::vector<std::string_view> line{words.begin(), words.end()};
+    session.assign(line.size(), line.data());
+
+    _conversions = 0;
+    CHECK_EQ(session.validate(), 0);
+    CHECK_EQ(_conversions, static_cast<int>(N));
+
+    // One keystroke, one conversion
+    CHECK_EQ(session.replace(N / 2, "--count=x"), 0);
+    CHECK_EQ(session.validate(), 1);
+    CHECK_EQ(session.errors()[0].position, N / 2);
+    CHECK_EQ(_conversions, static_cast<int>(N) + 1);
+}
+
+int main() {
+    testErrors();
+    testEdits();
+    testParse();
+    testSubcommands();
+    testLong();
+    return test::result();
+}
@@ -0,0 +1,136 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+// Overwrites every byte of s before it goes away, so that reading it later
+// gives garbage instead of the expected value by chance
+static void _scrub(std::string *s) {
+    s->assign(s->size(), '#');
+}
+
+static void _setup_deploy(cmdarg::Parser *parser) {
+    parser->addArgument({.long_opt = "target", .required = true});
+}
+
+static void testTemporaries() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+
+    std::string name = "level";
+    std::string help = "How loud to be";
+    std::string value = "low";
+    std::string env = "STRINGS_TEST_LEVEL";
+    std::vector<std::string> choices = {"low", "high"};
+    auto list = std::make_unique<const char *[]>(choices.size() + 1);
+    for (std::size_t i = 0; i < choices.size(); ++i) {
+        list[i] = choices[i].c_str();
+    }
+    list[choices.size()] = nullptr;
+
+    CHECK_EQ(parser.addArgument({
+                 .long_opt = name.c_str(),
+                 .parameter_required = Argument::ParameterRequired::REQUIRED,
+                 .help = help.c_str(),
+                 .default_value = value.c_str(),
+                 .action = cmdarg::actions::store_choice,
+                 .choices = list.get(),
+                 .env = env.c_str(),
+             }),
+             0);
+
+    for (auto *s : {&name, &help, &value, &env}) _scrub(s);
+    for (auto &choice : choices) _scrub(&choice);
+    list.reset();
+
+    ::unsetenv("STRINGS_TEST_LEVEL");
+    const std::string_view empty[] = {"prog"};
+    auto values = parser.parse(1, empty);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("level"), "low");
+
+    ::setenv("STRINGS_TEST_LEVEL", "high", 1);
+    values = parser.parse(1, empty);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("level"), "high");
+    ::unsetenv("STRINGS_TEST_LEVEL");
+
+    const std::string_view wrong[] = {"prog", "--level=loud"};
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    parser.parse(2, wrong);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+
+    const std::string text = parser.getHelp();
+    CHECK(text.find("--level") != std::string::npos);
+    CHECK(text.find("How loud to be") != std::string::npos);
+    CHECK(text.find('#') == std::string::npos);
+
+    // Subcommand names and help as well
+    std::string command = "deploy";
+    std::string command_help = "Ship it";
+    CHECK_EQ(parser.addSubcommand({
+                 .name = command.c_str(),
+                 .help = command_help.c_str(),
+                 .setup = _setup_deploy,
+             }),
+             0);
+    _scrub(&command);
+    _scrub(&command_help);
+
+    CHECK(parser.getHelp().find("Ship it") != std::string::npos);
+    const std::string_view deploy[] = {"prog", "deploy", "prod"};
+    values = parser.parse(3, deploy);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("command"), "deploy");
+    CHECK_EQ(values.at("target"), "prod");
+}
+
+static void testGenerated() {
+    constexpr int N = 2000;
+
+    // All names built in the same buffer, as generated code would
+    cmdarg::Parser parser{{.prog = "prog"}};
+    std::string name;
+    for (int i = 0; i < N; ++i) {
+        name = "option-" + std::to_string(i);
+        CHECK_EQ(parser.addArgument({
+                     .long_opt = name.c_str(),
+                     .parameter_required =
+                         Argument::ParameterRequired::REQUIRED,
+                     .help = "Generated option",
+                     .default_value = "0",
+                 }),
+                 0);
+    }
+
+    // Duplicates are still caught on the copies
+    name = "option-7";
+    CHECK(parser.addArgument({.long_opt = name.c_str()}) != 0);
+
+    _scrub(&name);
+    const std::string_view argv[] = {"prog", "--option-1234=x",
+                                      "--option-1999", "y"};
+    auto values = parser.parse(4, argv);
+    CHECK_EQ(values.size(), N + 1U);
+    CHECK_EQ(values.at("option-0"), "0");
+    CHECK_EQ(values.at("option-1234"), "x");
+    CHECK_EQ(values.at("option-1999"), "y");
+}
+
+int main() {
+    testTemporaries();
+    testGenerated();
+    return test::result();
+}
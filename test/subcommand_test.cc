@@ -0,0 +1,243 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+static int _build_setups = 0;
+
+static void _setup_build(cmdarg::Parser *parser) {
+    ++_build_setups;
+    parser->addArgument({
+        .long_opt = "jobs",
+        .short_opt = 'j',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "1",
+        .action = cmdarg::actions::store_positive_int,
+    });
+    parser->addArgument({.long_opt = "target", .required = true});
+}
+
+static void _setup_fast(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "now",
+        .action = cmdarg::actions::store_true,
+    });
+}
+
+static void _setup_run(cmdarg::Parser *parser) {
+    parser->addSubcommand({.name = "fast", .setup = _setup_fast});
+}
+
+static void testRegistration() {
+    cmdarg::Parser parser{{.prog = "tool"}};
+    CHECK_EQ(parser.addSubcommand({.name = "build"}), -1);
+    CHECK_EQ(parser.addSubcommand({.name = "", .setup = _setup_run}), -1);
+    CHECK_EQ(parser.addSubcommand({.name = "-x", .setup = _setup_run}), -1);
+    CHECK_EQ(parser.addSubcommand({.name = "run", .setup = _setup_run}), 0);
+    CHECK_EQ(parser.addSubcommand({.name = "run", .setup = _setup_run}), -2);
+
+    // Positional arguments and subcommands exclude each other
+    cmdarg::Parser positional{{.prog = "tool"}};
+    positional.addArgument({.long_opt = "file", .required = true});
+    CHECK_EQ(positional.addSubcommand({.name = "run", .setup = _setup_run}),
+             -3);
+
+    // "command" is the result key of the selected subcommand
+    cmdarg::Parser taken{{.prog = "tool"}};
+    taken.addArgument({.long_opt = "command"});
+    CHECK_EQ(taken.addSubcommand({.name = "run", .setup = _setup_run}), -2);
+}
+
+static void testParse() {
+    _build_setups = 0;
+
+    cmdarg::Parser parser{{.prog = "tool"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .action = cmdarg::actions::store_true,
+    });
+    parser.addSubcommand({.name = "build", .setup = _setup_build});
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+
+    // Set up only when selected
+    const std::string_view run[] = {"tool", "run", "fast", "--now"};
+    auto values = parser.parse(4, run);
+    CHECK(!parser.lastError());
+    CHECK_EQ(_build_setups, 0);
+    CHECK_EQ(values["command"], "run fast");
+    CHECK_EQ(values["now"], "true");
+    CHECK_EQ(values["verbose"], "");
+
+    // Values of the parent and of the subcommand are merged
+    const std::string_view build[] = {"tool", "-v", "build", "-j", "3", "all"};
+    values = parser.parse(6, build);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values["command"], "build");
+    CHECK_EQ(values["verbose"], "true");
+    CHECK_EQ(values["jobs"], "3");
+    CHECK_EQ(values["target"], "all");
+    CHECK_EQ(values.count("now"), 0U);
+
+    // ... and set up once
+    const std::string_view again[] = {"tool", "build", "lib"};
+    values = parser.parse(3, again);
+    CHECK_EQ(_build_setups, 1);
+    CHECK_EQ(values["jobs"], "1");
+    CHECK_EQ(values["target"], "lib");
+
+    // Options of the parent go before the subcommand name
+    const std::string_view late[] = {"tool", "build", "-v", "lib"};
+    parser.parse(4, late);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+}
+
+static void testErrors() {
+    cmdarg::Parser parser{{.prog = "tool"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addSubcommand({.name = "build", .setup = _setup_build});
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+
+    const std::string_view unknown[] = {"tool", "buidl"};
+    parser.parse(2, unknown);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_COMMAND);
+    CHECK_EQ(parser.lastError().token, "buidl");
+    CHECK_EQ(parser.lastError().suggestions.size(), 1U);
+    CHECK_EQ(parser.lastError().suggestions.front(), "build");
+
+    const std::string_view missing[] = {"tool"};
+    parser.parse(1, missing);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_ARGUMENTS);
+
+    // Errors of nested subcommands reach the same handler
+    const std::string_view nested[] = {"tool", "run", "slow"};
+    parser.parse(3, nested);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_COMMAND);
+    CHECK_EQ(parser.lastError().token, "slow");
+
+    const std::string_view target[] = {"tool", "build"};
+    parser.parse(2, target);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_ARGUMENTS);
+}
+
+static void _setup_clash(cmdarg::Parser *parser) {
+    parser->addArgument({.long_opt = "verbose"});
+}
+
+static void _setup_command(cmdarg::Parser *parser) {
+    parser->addArgument({.long_opt = "command"});
+}
+
+static void testSettings() {
+    cmdarg::Parser parser{{.prog = "tool"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addSubcommand({.name = "build", .setup = _setup_build});
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+
+    // Subcommands set up later get the settings of their parent
+    parser.setExitOnHelp(false);
+    const std::string_view help[] = {"tool", "build", "--help"};
+    parser.parse(3, help);
+    CHECK(parser.lastError().kind == ParseError::Kind::HELP_REQUESTED);
+    const std::string_view nested[] = {"tool", "run", "fast", "-h"};
+    parser.parse(4, nested);
+    CHECK(parser.lastError().kind == ParseError::Kind::HELP_REQUESTED);
+
+    // ... and so do those already set up
+    parser.setExitOnHelp(true);
+    parser.setExitOnHelp(false);
+    parser.parse(3, help);
+    CHECK(parser.lastError().kind == ParseError::Kind::HELP_REQUESTED);
+}
+
+static void testConflicts() {
+    cmdarg::Parser parser{{.prog = "tool"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addArgument({.long_opt = "verbose"});
+    parser.addSubcommand({.name = "clash", .setup = _setup_clash});
+    parser.addSubcommand({.name = "command", .setup = _setup_command});
+    parser.addSubcommand({.name = "run", .setup = _setup_run});
+
+    // Values of the subcommand would replace those of the parent
+    const std::string_view clash[] = {"tool", "--verbose", "clash"};
+    auto values = parser.parse(3, clash);
+    CHECK(parser.lastError().kind == ParseError::Kind::NAME_CONFLICT);
+    CHECK_EQ(parser.lastError().token, "--verbose");
+    CHECK_EQ(values["command"], "");
+
+    const std::string_view command[] = {"tool", "command"};
+    parser.parse(2, command);
+    CHECK(parser.lastError().kind == ParseError::Kind::NAME_CONFLICT);
+    CHECK_EQ(parser.lastError().token, "--command");
+
+    // --help and nested commands are not conflicts
+    const std::string_view run[] = {"tool", "run", "fast"};
+    values = parser.parse(3, run);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values["command"], "run fast");
+}
+
+// Overrides the help as it could before subcommands existed
+class Terse : public cmdarg::HelpFormatter {
+ public:
+    using HelpFormatter::HelpFormatter;
+    using HelpFormatter::formatHelp;
+
+    void formatHelp(std::ostream *os,
+                    const std::vector<Argument> &required,
+                    const std::vector<Argument> &optional) const override {
+        *os << required.size() << " required, " << optional.size()
+            << " optional" << std::endl;
+    }
+};
+
+static void testHelp() {
+    const std::vector<Argument> required = {{.long_opt = "file"}};
+    const std::vector<Argument> optional = {{.long_opt = "verbose"}};
+    const std::vector<cmdarg::Subcommand> commands = {
+        {.name = "run", .help = "Run it", .setup = _setup_run},
+    };
+
+    // Without subcommands, the override is used
+    Terse terse{{.prog = "tool"}};
+    std::ostringstream oss;
+    terse.formatHelp(&oss, required, optional, {});
+    CHECK_EQ(oss.str(), "1 required, 1 optional\n");
+
+    // With them, the default help lists them
+    oss.str("");
+    terse.formatHelp(&oss, {}, optional, commands);
+    CHECK(oss.str().find("usage: tool [--verbose] COMMAND ...") !=
+          std::string::npos);
+    CHECK(oss.str().find("Commands:\n    run") != std::string::npos);
+
+    // Same as the first release without any
+    cmdarg::HelpFormatter plain{{.prog = "tool"}};
+    std::ostringstream before;
+    std::ostringstream after;
+    plain.formatHelp(&before, required, optional);
+    plain.formatHelp(&after, required, optional, {});
+    CHECK_EQ(before.str(), after.str());
+    CHECK(before.str().find("COMMAND") == std::string::npos);
+}
+
+int main() {
+    testRegistration();
+    testParse();
+    testErrors();
+    testSettings();
+    testConflicts();
+    testHelp();
+    return test::result();
+}
@@ -0,0 +1,118 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+static void testEditDistance() {
+    CHECK_EQ(cmdarg::editDistance("", "", 3), 0);
+    CHECK_EQ(cmdarg::editDistance("verbose", "verbose", 3), 0);
+    CHECK_EQ(cmdarg::editDistance("verbose", "verbsoe", 3), 2);
+    CHECK_EQ(cmdarg::editDistance("count", "cont", 3), 1);
+    CHECK_EQ(cmdarg::editDistance("", "abc", 3), 3);
+
+    // Stops past max_distance
+    CHECK_EQ(cmdarg::editDistance("abcdef", "uvwxyz", 2), 3);
+}
+
+static void testIndex() {
+    cmdarg::SuggestionIndex index;
+    for (const char *name :
+         {"verbose", "version", "verify", "count", "color"}) {
+        index.add(name);
+    }
+    CHECK_EQ(index.size(), 5U);
+
+    auto found = index.suggest("verbos");
+    CHECK(!found.empty());
+    CHECK_EQ(found.front(), "verbose");
+
+    found = index.suggest("cuont", 1);
+    CHECK_EQ(found.size(), 0U);
+    found = index.suggest("cuont", 2);
+    CHECK_EQ(found.size(), 1U);
+
+    found = index.suggest("ver", 4, 2);
+    CHECK_EQ(found.size(), 2U);
+
+    CHECK(index.suggest("zzzzzzzz").empty());
+
+    // Ties keep insertion order, whatever the lexicographic one
+    cmdarg::SuggestionIndex ties;
+    ties.add("node");
+    ties.add("mode");
+    found = ties.suggest("ode", 1);
+    CHECK_EQ(found.size(), 2U);
+    CHECK_EQ(found[0], "node");
+    CHECK_EQ(found[1], "mode");
+
+    index.clear();
+    CHECK_EQ(index.size(), 0U);
+    CHECK(index.suggest("verbose").empty());
+
+    static const char *const choices[] = {"fast", "slow", "safe", nullptr};
+    cmdarg::SuggestionIndex from_list{choices};
+    CHECK_EQ(from_list.size(), 3U);
+    found = from_list.suggest("fsat");
+    CHECK(!found.empty());
+    CHECK_EQ(found.front(), "fast");
+}
+
+static void testParseErrors() {
+    static const char *const modes[] = {"fast", "slow", nullptr};
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addArgument({.long_opt = "verbose", .short_opt = 'v'});
+    parser.addArgument({.long_opt = "version"});
+    parser.addArgument({
+        .long_opt = "mode",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_choice,
+        .choices = modes,
+    });
+
+    const std::string_view unknown[] = {"prog", "--vrebose"};
+    parser.parse(2, unknown);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+    CHECK_EQ(parser.lastError().token, "--vrebose");
+    CHECK_EQ(parser.lastError().suggestions.size(), 1U);
+    CHECK_EQ(parser.lastError().suggestions.front(), "--verbose");
+
+    // Every option sharing the prefix is listed
+    const std::string_view ambiguous[] = {"prog", "--ver"};
+    parser.parse(2, ambiguous);
+    CHECK(parser.lastError().kind == ParseError::Kind::AMBIGUOUS_OPTION);
+    CHECK_EQ(parser.lastError().suggestions.size(), 2U);
+
+    // The actions print their own message
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    const std::string_view choice[] = {"prog", "--mode", "fsat"};
+    parser.parse(3, choice);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+    CHECK(!parser.lastError().suggestions.empty());
+    CHECK_EQ(parser.lastError().suggestions.front(), "fast");
+
+    // Suggestions are not carried over to the next parse
+    const std::string_view valid[] = {"prog", "--mode", "slow"};
+    auto values = parser.parse(3, valid);
+    CHECK(!parser.lastError());
+    CHECK(parser.lastError().suggestions.empty());
+    CHECK_EQ(values["mode"], "slow");
+}
+
+int main() {
+    testEditDistance();
+    testIndex();
+    testParseErrors();
+    return test::result();
+}
@@ -0,0 +1,188 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::ParseError;
+
+// Splits cmdline with a fresh arena of the given size (scratchSize if zero);
+// returns the result of split, the words in *out
+static int _split(std::string_view cmdline, std::vector<std::string> *out,
+                  std::size_t capacity = 0) {
+    if (capacity == 0) {
+        capacity = cmdarg::tokenizer::scratchSize(cmdline.size());
+    }
+    std::vector<char> buffer(capacity);
+    cmdarg::Arena arena{buffer.data(), buffer.size()};
+
+    const std::string_view *words = nullptr;
+    std::size_t count = 0;
+    int res = cmdarg::tokenizer::split(cmdline, &arena, &words, &count);
+
+    out->clear();
+    if (res == 0) out->assign(words, words + count);
+    return res;
+}
+
+static void testArena() {
+    alignas(8) char buffer[32];
+    cmdarg::Arena arena{buffer, sizeof(buffer)};
+    CHECK_EQ(arena.capacity(), 32U);
+
+    void *first = arena.allocate(3, 1);
+    CHECK(first == buffer);
+    void *second = arena.allocate(8, 8);
+    CHECK(second == buffer + 8);
+    CHECK_EQ(arena.used(), 16U);
+
+    CHECK(arena.allocate(17, 1) == nullptr);
+    CHECK_EQ(arena.used(), 16U);
+    CHECK(arena.allocate(16, 1) == buffer + 16);
+
+    arena.reset();
+    CHECK_EQ(arena.used(), 0U);
+    CHECK(arena.allocate(32, 8) == buffer);
+}
+
+static void testSplit() {
+    std::vector<std::string> words;
+
+    CHECK_EQ(_split("", &words), 0);
+    CHECK(words.empty());
+    CHECK_EQ(_split(" \t\n ", &words), 0);
+    CHECK(words.empty());
+
+    CHECK_EQ(_split("  -c 3\t--name=x\nfile  ", &words), 0);
+    CHECK(words == (std::vector<std::string>{"-c", "3", "--name=x", "file"}));
+
+    // Quotes and escapes
+    CHECK_EQ(_split(R"('a b' "c d" e\ f g'h'"i")", &words), 0);
+    CHECK(words == (std::vector<std::string>{"a b", "c d", "e f", "ghi"}));
+    CHECK_EQ(_split(R"('\n' "\"\\\$\`\a")", &words), 0);
+    CHECK(words == (std::vector<std::string>{"\\n", "\"\\$`\\a"}));
+    CHECK_EQ(_split("''  \"\"", &words), 0);
+    CHECK(words == (std::vector<std::string>{"", ""}));
+
+    // Backslash-newline pairs are removed, within double quotes as well
+    CHECK_EQ(_split("a\\\nb \"c\\\nd\"", &words), 0);
+    CHECK(words == (std::vector<std::string>{"ab", "cd"}));
+
+    // Between words they start none
+    CHECK_EQ(_split("a \\\n b \\\n", &words), 0);
+    CHECK(words == (std::vector<std::string>{"a", "b"}));
+
+    // Nothing is expanded
+    CHECK_EQ(_split("$HOME `ls` ~ *", &words), 0);
+    CHECK(words == (std::vector<std::string>{"$HOME", "`ls`", "~", "*"}));
+
+    // Comments only at the start of a word
+    CHECK_EQ(_split("a # b c\nd e#f '#g'", &words), 0);
+    CHECK(words == (std::vector<std::string>{"a", "d", "e#f", "#g"}));
+
+    CHECK_EQ(_split("a 'b", &words), -1);
+    CHECK_EQ(_split("a \"b\\\"", &words), -1);
+    CHECK_EQ(_split("a b\\", &words), -1);
+}
+
+static void testZeroCopy() {
+    const std::string_view cmdline = "plain 'quoted' also-plain";
+    const std::size_t capacity =
+        cmdarg::tokenizer::scratchSize(cmdline.size());
+    std::vector<char> buffer(capacity);
+    cmdarg::Arena arena{buffer.data(), buffer.size()};
+
+    const std::string_view *words;
+    std::size_t count;
+    CHECK_EQ(cmdarg::tokenizer::split(cmdline, &arena, &words, &count), 0);
+    CHECK_EQ(count, 3U);
+
+    // Plain words point into the command string, the others into the arena
+    const char *begin = cmdline.data();
+    const char *end = begin + cmdline.size();
+    CHECK(words[0].data() == begin);
+    CHECK(words[1].data() >= buffer.data() &&
+          words[1].data() < buffer.data() + buffer.size());
+    CHECK(words[2].data() >= begin && words[2].data() < end);
+    CHECK_EQ(words[1], "quoted");
+}
+
+static void testScratchSize() {
+    std::vector<std::string> words;
+
+    // The worst cases for both the array of words and unquoted copies
+    for (const char *cmdline :
+         {"a", "a b c d e f g", "'' '' ''", "\\a\\b \\c", "\"x\"y'z'",
+          "a\\ b\\ c"}) {
+        CHECK_EQ(_split(cmdline, &words), 0);
+    }
+
+    // Too small an arena fails cleanly
+    CHECK_EQ(_split("a b c", &words, 8), -2);
+    CHECK_EQ(_split("'a' 'b'", &words, 2 * sizeof(std::string_view)), -2);
+}
+
+static void testParse() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    parser.addArgument({
+        .long_opt = "count",
+        .short_opt = 'c',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .default_value = "1",
+        .action = cmdarg::actions::store_int,
+    });
+    parser.addArgument({
+        .long_opt = "name",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+    });
+    parser.addArgument({.long_opt = "file", .required = true});
+
+    alignas(8) char buffer[512];
+    cmdarg::Arena arena{buffer, sizeof(buffer)};
+
+    // The first word is already an argument
+    auto values = parser.parse("-c 4 --name 'two words' input.txt", &arena);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("count"), "4");
+    CHECK_EQ(values.at("name"), "two words");
+    CHECK_EQ(values.at("file"), "input.txt");
+
+    // Comments run to the end of the line
+    arena.reset();
+    values = parser.parse("data.bin # the rest is ignored -c 9", &arena);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("count"), "1");
+    CHECK_EQ(values.at("file"), "data.bin");
+
+    arena.reset();
+    parser.parse("--name 'unterminated", &arena);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_COMMAND_LINE);
+    CHECK_EQ(parser.lastError().token, "--name 'unterminated");
+
+    // Out of scratch memory
+    cmdarg::Arena tiny{buffer, 4};
+    parser.parse("a b c", &tiny);
+    CHECK(parser.lastError().kind == ParseError::Kind::ARENA_EXHAUSTED);
+    CHECK_EQ(parser.lastError().token, "a b c");
+
+    arena.reset();
+    parser.parse("-c", &arena);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_PARAMETER);
+}
+
+int main() {
+    testArena();
+    testSplit();
+    testZeroCopy();
+    testScratchSize();
+    testParse();
+    return test::result();
+}
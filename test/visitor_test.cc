@@ -0,0 +1,213 @@
+// Copyright 2022 Gabriele Ara
+// Licensed by GNU GENERAL PUBLIC LICENSE v3.0
+
+// System headers
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "check.hpp"
+
+using cmdarg::Argument;
+using cmdarg::Event;
+using cmdarg::ParseError;
+
+static void _add_arguments(cmdarg::Parser *parser) {
+    parser->addArgument({
+        .long_opt = "add",
+        .short_opt = 'a',
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+    });
+    parser->addArgument({
+        .long_opt = "remove",
+        .parameter_required = Argument::ParameterRequired::REQUIRED,
+        .action = cmdarg::actions::store_int,
+    });
+    parser->addArgument({
+        .long_opt = "verbose",
+        .short_opt = 'v',
+        .default_value = "0",
+        .action = cmdarg::actions::increment_int,
+        .env = "VISITOR_TEST_VERBOSE",
+    });
+    parser->addArgument({.long_opt = "file", .required = true});
+}
+
+// Keeps every event as "name=value>converted@position"
+class Recorder : public cmdarg::Visitor {
+ public:
+    std::vector<std::string> options;
+    std::vector<std::string> positionals;
+    std::vector<std::uint32_t> ids;
+
+    // Stops at this option, returning 42
+    std::string stop_at;
+
+    int onOption(const Event &event) override {
+        ids.push_back(event.id);
+        options.push_back(_format(event));
+        return (event.name == stop_at) ? 42 : 0;
+    }
+
+    int onPositional(const Event &event) override {
+        ids.push_back(event.id);
+        positionals.push_back(_format(event));
+        return 0;
+    }
+
+ private:
+    static std::string _format(const Event &event) {
+        return std::string(event.name) + "=" + std::string(event.value) +
+               ">" + std::string(event.converted) + "@" +
+               std::to_string(event.position);
+    }
+};
+
+static void testEvents() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    // The environment is not visited
+    ::setenv("VISITOR_TEST_VERBOSE", "9", 1);
+
+    const std::string_view argv[] = {"prog", "--add", "x",     "-vv", "in",
+                                     "-ay",  "--remove=3", "extra", "--",
+                                     "-v"};
+    Recorder recorder;
+    CHECK_EQ(parser.visit(10, argv, &recorder), 0);
+    ::unsetenv("VISITOR_TEST_VERBOSE");
+
+    // Actions are applied, increments count occurrences
+    CHECK(recorder.options == (std::vector<std::string>{
+                                  "add=x>x@1",
+                                  "verbose=>1@3",
+                                  "verbose=>2@3",
+                                  "add=y>y@5",
+                                  "remove=3>3@6",
+                              }));
+    CHECK(recorder.positionals == (std::vector<std::string>{
+                                      "file=in>in@4",
+                                      "=extra>extra@7",
+                                      "=-v>-v@9",
+                                  }));
+
+    CHECK_EQ(recorder.ids[0], parser.argumentId("add"));
+    CHECK_EQ(recorder.ids[1], parser.argumentId("verbose"));
+    CHECK_EQ(recorder.ids[3], parser.argumentId("file"));
+    CHECK_EQ(recorder.ids[5], parser.argumentId("remove"));
+    CHECK_EQ(recorder.ids[6], cmdarg::NO_ARGUMENT);
+    CHECK_EQ(parser.argumentId("missing"), cmdarg::NO_ARGUMENT);
+    CHECK(parser.argumentId("add") != parser.argumentId("remove"));
+
+    // Same through char *argv
+    char prog[] = "prog";
+    char add[] = "-az";
+    char file[] = "f";
+    char *raw[] = {prog, add, file, nullptr};
+    Recorder again;
+    CHECK_EQ(parser.visit(3, raw, &again), 0);
+    CHECK(again.options == (std::vector<std::string>{"add=z>z@1"}));
+    CHECK(again.positionals == (std::vector<std::string>{"file=f>f@2"}));
+
+    // Not even the program name
+    char *none[] = {nullptr};
+    Recorder empty;
+    CHECK_EQ(parser.visit(0, none, &empty), -1);
+    CHECK(empty.options.empty());
+}
+
+static void testStop() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.setErrorHandler(test::keepError);
+    _add_arguments(&parser);
+
+    const std::string_view argv[] = {"prog", "-a", "1", "--remove", "2",
+                                     "-a", "3", "in"};
+    Recorder recorder;
+    recorder.stop_at = "remove";
+    CHECK_EQ(parser.visit(8, argv, &recorder), 42);
+    CHECK_EQ(recorder.options.size(), 2U);
+    CHECK(recorder.positionals.empty());
+    CHECK(!parser.lastError());
+
+    // Invalid values stop with an error, after the events before them
+    const std::string_view invalid[] = {"prog", "-a", "1", "--remove=x",
+                                        "in"};
+    Recorder failed;
+    const bool quiet = cmdarg::actions::setQuiet(true);
+    CHECK_EQ(parser.visit(5, invalid, &failed), -1);
+    cmdarg::actions::setQuiet(quiet);
+    CHECK(parser.lastError().kind == ParseError::Kind::INVALID_VALUE);
+    CHECK_EQ(failed.options.size(), 1U);
+
+    const std::string_view unknown[] = {"prog", "--bogus", "in"};
+    CHECK_EQ(parser.visit(3, unknown, &failed), -1);
+    CHECK(parser.lastError().kind == ParseError::Kind::UNKNOWN_OPTION);
+
+    const std::string_view missing[] = {"prog", "-a", "1"};
+    CHECK_EQ(parser.visit(3, missing, &failed), -1);
+    CHECK(parser.lastError().kind == ParseError::Kind::MISSING_ARGUMENTS);
+
+    // Visits leave parse as it was
+    const std::string_view plain[] = {"prog", "in"};
+    auto values = parser.parse(2, plain);
+    CHECK(!parser.lastError());
+    CHECK_EQ(values.at("add"), "");
+    CHECK_EQ(values.at("file"), "in");
+}
+
+static void _setup(cmdarg::Parser * /*parser*/) {
+}
+
+static void testSubcommands() {
+    cmdarg::Parser parser{{.prog = "prog"}};
+    parser.addSubcommand({.name = "run", .setup = _setup});
+
+    const std::string_view argv[] = {"prog", "run"};
+    Recorder recorder;
+    CHECK_EQ(parser.visit(2, argv, &recorder), -2);
+    CHECK(recorder.options.empty());
+}
+
+// Counts events only, keeping nothing
+class Counter : public cmdarg::Visitor {
+ public:
+    std::size_t count = 0;
+    std::size_t last_position = 0;
+
+    int onOption(const Event &event) override {
+        ++count;
+        last_position = event.position;
+        return 0;
+    }
+};
+
+static void testLong() {
+    constexpr std::size_t N = 100000;
+
+    cmdarg::Parser parser{{.prog = "prog"}};
+    _add_arguments(&parser);
+
+    std::vector<std::string> words = {"prog", "in"};
+    for (std::size_t i = 0; i < N; ++i) {
+        words.push_back("--add=" + std::to_string(i));
+    }
+    const std::vector<std::string_view> argv{words.begin(), words.end()};
+
+    Counter counter;
+    CHECK_EQ(parser.visit(argv.size(), argv.data(), &counter), 0);
+    CHECK_EQ(counter.count, N);
+    CHECK_EQ(counter.last_position, N + 1);
+}
+
+int main() {
+    testEvents();
+    testStop();
+    testSubcommands();
+    testLong();
+    return test::result();
+}